@@ -0,0 +1,108 @@
+/*      File: curve_handle.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace rtp {
+
+class RTPlotCore;
+struct CurveData;
+
+/**
+ * Direct access to a curve of a plot. Obtained once with
+ * RTPlotCore::getCurveHandle() or RTPlot::getCurveHandle(), it avoids looking
+ * up the plot and the curve each time a point is added.
+ *
+ * A handle stays valid as long as the plot it has been obtained from exists.
+ */
+class CurveHandle {
+public:
+    /**
+     * Create an invalid handle
+     */
+    CurveHandle();
+
+    /**
+     * Add a new point to the curve. Never allocates memory or performs I/O if
+     * the curve's storage has been reserved (see RTPlotCore::reserve()). The
+     * curve's lock boosts its holder if needed, so a renderer can't delay
+     * the point for more than a short critical section.
+     * @param x the x coordinate of the point.
+     * @param y the y coordinate of the point.
+     * @return false if the curve is uniformly sampled, true otherwise
+     */
+    bool addPoint(float x, float y);
+
+    /**
+     * Add several points to the curve at once. Same real time guarantees as
+     * addPoint().
+     * @param xs    the x coordinates of the points.
+     * @param ys    the y coordinates of the points.
+     * @param count the number of points.
+     * @return false if the curve is uniformly sampled, true otherwise
+     */
+    bool addPoints(const float* xs, const float* ys, size_t count);
+
+    /**
+     * Add a new sample to the curve. The curve must be uniformly sampled (see
+     * RTPlotCore::setUniformSampling()). Same real time guarantees as
+     * addPoint().
+     * @param y the y coordinate of the sample.
+     * @return false if the curve is not uniformly sampled, true otherwise
+     */
+    bool addSample(float y);
+
+    /**
+     * Add several samples to the curve at once. Same real time guarantees as
+     * addPoint().
+     * @param ys    the y coordinates of the samples.
+     * @param count the number of samples.
+     * @return false if the curve is not uniformly sampled, true otherwise
+     */
+    bool addSamples(const float* ys, size_t count);
+
+    /**
+     * Remove the first point of the curve.
+     */
+    void removeFirstPoint();
+
+    /**
+     * Get the index of the curve
+     * @return the user defined index of the curve
+     */
+    int getCurve() const;
+
+    /**
+     * Check if the handle refers to a curve
+     * @return true if the handle can be used, false otherwise
+     */
+    bool isValid() const;
+
+private:
+    friend class RTPlotCore;
+
+    CurveHandle(RTPlotCore* plot, CurveData* data);
+
+    RTPlotCore* plot_;
+    CurveData* data_;
+};
+
+} // namespace rtp
@@ -0,0 +1,35 @@
+/*      File: export_format.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+namespace rtp {
+
+/**
+ * File formats available to export the content of a plot
+ */
+enum class ExportFormat {
+    // Text with a "curve,x,y" header and one line per sample
+    CSV,
+    // Self-describing binary format storing each curve as two columns of
+    // 32 bits floats, see RTPlotCore::exportData() for the layout
+    Binary
+};
+
+} // namespace rtp
@@ -0,0 +1,43 @@
+/*      File: ingestion_filter.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+namespace rtp {
+
+/**
+ * Filters applied to the samples of a curve before storing them. The input
+ * samples are processed by blocks whose size is the filter's factor.
+ */
+enum class IngestionFilter {
+    // Every sample is stored
+    None,
+    // Only the first sample of each block is stored
+    KeepNth,
+    // The mean of each block is stored
+    BlockAverage,
+    // The minimum and the maximum of each block are stored, in their
+    // original order, so that the peaks stay visible
+    BlockMinMax,
+    // A first order low pass filter, with a time constant of one block, is
+    // applied and its output stored at the end of each block
+    LowPass
+};
+
+} // namespace rtp
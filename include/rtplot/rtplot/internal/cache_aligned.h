@@ -0,0 +1,74 @@
+/*      File: cache_aligned.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace rtp {
+
+/**
+ * Size of a cache line on the targeted architectures
+ */
+constexpr size_t cache_line_size = 64;
+
+/**
+ * Base class giving cache line aligned dynamic allocation to the derived
+ * classes. C++14's operator new ignores the alignment of over-aligned types,
+ * which must be declared as alignas(cache_line_size) to be padded to a
+ * multiple of a cache line.
+ */
+struct CacheAligned {
+    static void* operator new(size_t size) {
+        return allocate(size);
+    }
+
+    static void* operator new[](size_t size) {
+        return allocate(size);
+    }
+
+    static void operator delete(void* ptr) {
+        deallocate(ptr);
+    }
+
+    static void operator delete[](void* ptr) {
+        deallocate(ptr);
+    }
+
+private:
+    // The pointer returned by ::operator new is stored right before the
+    // aligned block
+    static void* allocate(size_t size) {
+        void* raw = ::operator new(size + cache_line_size);
+        auto address = (reinterpret_cast<uintptr_t>(raw) + cache_line_size) &
+                       ~uintptr_t(cache_line_size - 1);
+        reinterpret_cast<void**>(address)[-1] = raw;
+        return reinterpret_cast<void*>(address);
+    }
+
+    static void deallocate(void* ptr) {
+        if (ptr) {
+            ::operator delete(reinterpret_cast<void**>(ptr)[-1]);
+        }
+    }
+};
+
+} // namespace rtp
@@ -0,0 +1,113 @@
+/*      File: compressed_block.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace rtp {
+
+/**
+ * Immutable, losslessly compressed block of consecutive curve samples.
+ *
+ * The y values use the XOR encoding of Facebook's Gorilla database: each value
+ * is XORed with the previous one and only the meaningful bits of the result
+ * are stored. The x values, when present, use a delta-of-delta encoding of
+ * their binary representation, which shrinks regularly spaced coordinates to a
+ * single bit per sample.
+ *
+ * The bounds of the samples are kept uncompressed so that a block can be drawn
+ * as a simple envelope without being decoded.
+ */
+class CompressedBlock {
+public:
+    using PointXY = std::pair<float, float>;
+
+    /**
+     * Compress points with both their x and y coordinates
+     * @param points the points to compress
+     */
+    explicit CompressedBlock(const std::vector<PointXY>& points);
+
+    /**
+     * Compress the y values of a uniformly sampled curve
+     * @param values the values to compress
+     */
+    explicit CompressedBlock(const std::vector<float>& values);
+
+    /**
+     * Decode the points of the block. Must only be used on blocks created
+     * with points.
+     * @param points the vector to fill, previous content is removed
+     */
+    void decode(std::vector<PointXY>& points) const;
+
+    /**
+     * Decode the y values of the block
+     * @param values the vector to fill, previous content is removed
+     */
+    void decode(std::vector<float>& values) const;
+
+    size_t size() const {
+        return count_;
+    }
+
+    bool hasX() const {
+        return has_x_;
+    }
+
+    // Bounds of the samples, xMin() and xMax() are only meaningful if hasX()
+    float xMin() const {
+        return xmin_;
+    }
+
+    float xMax() const {
+        return xmax_;
+    }
+
+    float yMin() const {
+        return ymin_;
+    }
+
+    float yMax() const {
+        return ymax_;
+    }
+
+    /**
+     * Number of bytes used by the block
+     * @return the size in bytes
+     */
+    size_t memoryUsage() const;
+
+private:
+    template <typename Getter> void encode(size_t count, Getter get);
+
+    std::vector<uint64_t> bits_;
+    size_t count_;
+    bool has_x_;
+    float xmin_;
+    float xmax_;
+    float ymin_;
+    float ymax_;
+};
+
+} // namespace rtp
@@ -0,0 +1,222 @@
+/*      File: curve_data.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <rtplot/internal/cache_aligned.h>
+#include <rtplot/internal/compressed_block.h>
+#include <rtplot/internal/priority_mutex.h>
+#include <rtplot/internal/running_statistics.h>
+#include <rtplot/internal/sample_filter.h>
+#include <rtplot/internal/segmented_buffer.h>
+#include <rtplot/internal/sliding_extrema.h>
+#include <rtplot/internal/trigger_capture.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rtp {
+
+class RTPlotCore;
+struct CurveData;
+
+/**
+ * Group of curves receiving their samples together, one frame at a time, and
+ * sharing the same x coordinates. The x column is stored once for all the
+ * channels.
+ */
+struct alignas(cache_line_size) FrameSeries : CacheAligned {
+    FrameSeries()
+        : x_increasing(true), max_points(std::numeric_limits<size_t>::max()) {
+    }
+
+    // Curve of each channel, the samples of channel i being stored in the
+    // values of channels[i]
+    std::vector<CurveData*> channels;
+    SegmentedBuffer<float> x;
+    // Bounds of x, only maintained while the automatic x range is enabled
+    SlidingExtrema x_extrema;
+    // Whether each frame's x coordinate is greater or equal to the previous
+    // one, until the series becomes empty again
+    bool x_increasing;
+    // Maximum number of frames, shared by all the channels. The x extrema are
+    // tracked if the first channel tracks its own ones
+    size_t max_points;
+    // Protects the series and all of its channels
+    PriorityMutex lock_;
+};
+
+/**
+ * Storage and properties of a single curve. Each curve occupies its own cache
+ * lines so that producers writing to different curves don't slow each other
+ * down.
+ */
+struct alignas(cache_line_size) CurveData : CacheAligned {
+    using PointXY = std::pair<float, float>;
+
+    explicit CurveData(int id)
+        : id(id),
+          track_x_extrema(false),
+          track_y_extrema(false),
+          track_statistics(false),
+          x_increasing(true),
+          max_points(std::numeric_limits<size_t>::max()),
+          points_added(0),
+          points_evicted(0),
+          is_uniform(false),
+          x0(0.f),
+          dx(1.f),
+          first_sample(0),
+          generation(0),
+          input_x0(0.f),
+          input_dx(1.f),
+          input_samples(0),
+          raw_samples(0),
+          cold_size(0),
+          cold_offset(0),
+          series(nullptr) {
+    }
+
+    /**
+     * Number of samples currently stored
+     * @return the number of samples
+     */
+    size_t size() const {
+        return cold_size + rawSize();
+    }
+
+    /**
+     * Number of samples stored uncompressed
+     * @return the number of samples
+     */
+    size_t rawSize() const {
+        return is_uniform or series ? values.size() : points.size();
+    }
+
+    /**
+     * Tell if y_extrema has to be maintained
+     * @return true if the y extrema are needed
+     */
+    bool tracksYExtrema() const {
+        return track_y_extrema or track_statistics;
+    }
+
+    /**
+     * Lock protecting the curve: its own one or the one of its FrameSeries
+     * @return the lock
+     */
+    PriorityMutex& curveLock() {
+        auto frame_series = series.load(std::memory_order_acquire);
+        return frame_series ? frame_series->lock_ : lock_;
+    }
+
+    /**
+     * Compute the x coordinate of a sample of a uniformly sampled curve
+     * @param idx the index of the sample among the stored ones
+     * @return the x coordinate
+     */
+    float sampleX(size_t idx) const {
+        return float(x0 + double(first_sample + idx) * dx);
+    }
+
+    // User defined index of the curve
+    const int id;
+    SegmentedBuffer<PointXY> points;
+    // Bounds of the stored values, only maintained while the corresponding
+    // track flag is set, i.e while a plot showing the curve has its automatic
+    // range enabled. Uniformly sampled curves don't use x_extrema
+    SlidingExtrema x_extrema;
+    SlidingExtrema y_extrema;
+    bool track_x_extrema;
+    bool track_y_extrema;
+    // Mean and variance of the stored y values, only maintained while
+    // track_statistics is set, i.e while a plot showing the curve has its
+    // statistics enabled. y_extrema is then maintained too
+    RunningStatistics statistics;
+    bool track_statistics;
+    // Whether each point's x coordinate is greater or equal to the previous
+    // one, until the curve becomes empty again. Always true for uniformly
+    // sampled curves
+    bool x_increasing;
+    // Plots displaying the curve, to invalidate when it changes
+    std::vector<RTPlotCore*> plots;
+    std::string label;
+    size_t max_points;
+    uint64_t points_added;
+    uint64_t points_evicted;
+    // Uniformly sampled curves only store their y values in values, the x
+    // coordinate being computed from x0, dx and the sample's index
+    bool is_uniform;
+    SegmentedBuffer<float> values;
+    float x0;
+    float dx;
+    // Number of samples removed since the curve's content was last replaced
+    uint64_t first_sample;
+    // Identifies the curve's content, changed each time the stored samples
+    // are all discarded. Unique among all the curves
+    uint64_t generation;
+    // Sampling given by the user, x0 and dx being the ones of the samples
+    // stored after filtering
+    float input_x0;
+    float input_dx;
+    // Number of samples received since the sampling has been set
+    uint64_t input_samples;
+    // Applied to the incoming samples before storing them
+    SampleFilter filter;
+    // Captures the samples around the trigger events, if a trigger is set.
+    // Fed with the stored samples
+    std::unique_ptr<TriggerCapture> trigger;
+    // When the stored samples have been added, to evict the oldest ones
+    // first when the memory budget is exceeded. Holds the position of one
+    // sample every age_mark_interval and the steady clock time at which it
+    // was stored, starting with the last mark before first_sample
+    RingBuffer<std::pair<uint64_t, uint64_t>> age_marks;
+    // Number of most recent samples kept uncompressed, zero if the compression
+    // is disabled. Older samples are moved to cold_blocks
+    size_t raw_samples;
+    // Compressed samples, older than the ones in points or values
+    std::deque<std::shared_ptr<const CompressedBlock>> cold_blocks;
+    // Number of samples in cold_blocks, minus the removed ones
+    size_t cold_size;
+    // Number of samples already removed from the first cold block
+    size_t cold_offset;
+    // First compressed block and its decoded y values, to update the
+    // statistics when its samples are removed
+    std::shared_ptr<const CompressedBlock> front_block;
+    std::vector<float> front_block_ys;
+    // Temporary storage for the samples being compressed
+    std::vector<PointXY> compression_points;
+    std::vector<float> compression_values;
+    // Series the curve belongs to, if any. Its y values are then stored in
+    // values and its x coordinates in the series. Set only once, while
+    // holding lock_
+    std::atomic<FrameSeries*> series;
+    // Protects everything but id and series until the curve joins a series.
+    // Shared with the renderers, so it boosts them to the priority of a
+    // producer waiting for it. Use curveLock()
+    PriorityMutex lock_;
+};
+
+} // namespace rtp
@@ -0,0 +1,104 @@
+/*      File: curve_snapshot.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <rtplot/metrics.h>
+#include <rtplot/internal/compressed_block.h>
+#include <rtplot/internal/segmented_buffer.h>
+#include <rtplot/internal/trigger_capture.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rtp {
+
+/**
+ * Content of a curve at a given time. Only references the curve's storage,
+ * which can be read without holding the curve's lock.
+ */
+struct CurveSnapshot {
+    using PointXY = std::pair<float, float>;
+
+    /**
+     * Number of samples in the snapshot
+     * @return the number of samples
+     */
+    size_t size() const {
+        return cold_size +
+               (is_uniform or is_series ? values.size() : points.size());
+    }
+
+    /**
+     * Read the samples, oldest first, by chunks of limited size. The
+     * compressed samples are decoded one block at a time.
+     * @param callback called for each chunk with its points and their number
+     * @param first    index of the first sample to read
+     */
+    void read(const std::function<void(const PointXY*, size_t)>& callback,
+              size_t first = 0) const;
+
+    /**
+     * Release the referenced storage
+     */
+    void clear() {
+        points.clear();
+        values.clear();
+        xs.clear();
+        cold_blocks.clear();
+        sweeps.clear();
+    }
+
+    int curve;
+    SegmentedBuffer<PointXY>::View points;
+    // Uniformly sampled curves only
+    SegmentedBuffer<float>::View values;
+    bool is_uniform;
+    // Curves of the frame series only, x coordinates of the values
+    SegmentedBuffer<float>::View xs;
+    bool is_series;
+    // See CurveData::x_increasing
+    bool x_increasing;
+    // x coordinate of the first value
+    double x0;
+    double dx;
+    // Position of the first sample and generation of the curve's content, see
+    // CurveData
+    uint64_t first_sample;
+    uint64_t generation;
+    // Compressed samples, older than the ones in points or values
+    std::vector<std::shared_ptr<const CompressedBlock>> cold_blocks;
+    size_t cold_offset;
+    size_t cold_size;
+    std::string label;
+    bool is_visible;
+    // Empty if the curve's statistics are not maintained
+    CurveStatistics statistics;
+    // Whether a trigger is set on the curve, only its completed sweeps being
+    // displayed then
+    bool triggered;
+    std::vector<std::shared_ptr<const TriggerSweep>> sweeps;
+};
+
+} // namespace rtp
@@ -0,0 +1,88 @@
+/*      File: density_histogram.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace rtp {
+
+/**
+ * Number of samples falling in each pixel of a plot area. Samples are
+ * accumulated as they arrive so that rendering the histogram only depends on
+ * its size and not on the number of samples.
+ */
+class DensityHistogram {
+public:
+    using PointXY = std::pair<float, float>;
+
+    DensityHistogram();
+
+    /**
+     * Change the size of the histogram. All the counts are reset.
+     * @param width  the width in pixels
+     * @param height the height in pixels
+     */
+    void resize(size_t width, size_t height);
+
+    size_t width() const;
+    size_t height() const;
+
+    /**
+     * Reset all the counts
+     */
+    void clear();
+
+    /**
+     * Multiply all the counts by the given factor, to make the older samples
+     * fade out
+     * @param factor the factor, in the [0,1] interval
+     */
+    void decay(float factor);
+
+    /**
+     * Count a sample. Samples outside of the histogram are ignored.
+     * @param point the sample's position relative to the top left corner of
+     * the histogram, in pixels
+     */
+    void add(const PointXY& point);
+
+    /**
+     * Convert the counts to 8 bits intensities using a logarithmic scale, the
+     * most populated pixel getting the maximum intensity
+     * @param intensities storage for width * height intensities, row by row
+     */
+    void render(uint8_t* intensities) const;
+
+    /**
+     * Number of bytes allocated for the counts
+     * @return the size in bytes
+     */
+    size_t memoryUsage() const;
+
+private:
+    std::vector<float> counts_;
+    size_t width_;
+    size_t height_;
+};
+
+} // namespace rtp
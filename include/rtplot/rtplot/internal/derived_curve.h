@@ -0,0 +1,230 @@
+/*      File: derived_curve.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <rtplot/internal/curve_snapshot.h>
+#include <rtplot/internal/ring_buffer.h>
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace rtp {
+
+/**
+ * Curve computed from other curves, its sources. The samples are evaluated
+ * by the renderer from snapshots of the sources, incrementally: only the
+ * samples added to the sources since the previous evaluation are processed.
+ * The whole curve is computed again if the content of a source is replaced
+ * or if samples not processed yet have already been removed from it.
+ */
+class DerivedCurve {
+public:
+    using PointXY = std::pair<float, float>;
+
+    /**
+     * @param sources the indexes of the source curves
+     */
+    explicit DerivedCurve(std::vector<int> sources);
+
+    virtual ~DerivedCurve() = default;
+
+    /**
+     * The indexes of the source curves
+     * @return the indexes
+     */
+    const std::vector<int>& sources() const {
+        return sources_;
+    }
+
+    /**
+     * Compute the new samples of the curve
+     * @param sources the snapshots of the sources, in the order given by
+     * sources()
+     * @param output  filled with the new samples
+     * @return true if the curve's samples must be replaced by output, false
+     * if output must be appended to them
+     */
+    bool update(const std::vector<CurveSnapshot>& sources,
+                std::vector<PointXY>& output);
+
+    /**
+     * Number of bytes allocated for the evaluation state
+     * @return the size in bytes
+     */
+    virtual size_t memoryUsage() const;
+
+protected:
+    /**
+     * Discard the evaluation state, the curve being computed again from the
+     * first stored samples of its sources
+     */
+    virtual void reset() = 0;
+
+    /**
+     * Compute the new samples of the curve
+     * @param sources the snapshots of the sources
+     * @param output  filled with the new samples
+     * @return true if the curve's samples must be replaced by output
+     */
+    virtual bool evaluate(const std::vector<CurveSnapshot>& sources,
+                          std::vector<PointXY>& output) = 0;
+
+    /**
+     * Number of samples of a source not processed yet
+     * @param source   the position of the source in sources()
+     * @param snapshot the source's snapshot
+     * @return the number of samples
+     */
+    size_t pending(size_t source, const CurveSnapshot& snapshot) const;
+
+    /**
+     * Read the samples of a source not processed yet and mark them as
+     * processed
+     * @param source   the position of the source in sources()
+     * @param snapshot the source's snapshot
+     * @param callback called for each chunk of samples
+     */
+    void readPending(
+        size_t source, const CurveSnapshot& snapshot,
+        const std::function<void(const PointXY*, size_t)>& callback);
+
+    /**
+     * Mark all the samples of a source as processed without reading them
+     * @param source   the position of the source in sources()
+     * @param snapshot the source's snapshot
+     */
+    void skipPending(size_t source, const CurveSnapshot& snapshot);
+
+private:
+    // Position, since the content was last replaced, of the next sample to
+    // process in a source
+    struct Cursor {
+        uint64_t generation;
+        uint64_t next;
+    };
+
+    std::vector<int> sources_;
+    std::vector<Cursor> cursors_;
+    bool started_;
+};
+
+/**
+ * Source's samples multiplied by a gain plus an offset
+ */
+class ScaledCurve : public DerivedCurve {
+public:
+    ScaledCurve(int source, float gain, float offset);
+
+protected:
+    void reset() override;
+    bool evaluate(const std::vector<CurveSnapshot>& sources,
+                  std::vector<PointXY>& output) override;
+
+private:
+    float gain_;
+    float offset_;
+};
+
+/**
+ * Difference between two sources, at the x coordinates of the first one. The
+ * second one is linearly interpolated, a sample of the first one being
+ * evaluated once the second one has reached its x coordinate. The x
+ * coordinates of both sources must be increasing.
+ */
+class DifferenceCurve : public DerivedCurve {
+public:
+    DifferenceCurve(int lhs, int rhs);
+
+    size_t memoryUsage() const override;
+
+protected:
+    void reset() override;
+    bool evaluate(const std::vector<CurveSnapshot>& sources,
+                  std::vector<PointXY>& output) override;
+
+private:
+    // Samples of the first source not evaluated yet
+    RingBuffer<PointXY> lhs_;
+    // Samples of the second source, starting with the last one before the
+    // next sample to evaluate
+    RingBuffer<PointXY> rhs_;
+};
+
+/**
+ * Mean of the last samples of the source, at the x coordinate of the most
+ * recent one
+ */
+class MovingAverageCurve : public DerivedCurve {
+public:
+    MovingAverageCurve(int source, size_t window);
+
+    size_t memoryUsage() const override;
+
+protected:
+    void reset() override;
+    bool evaluate(const std::vector<CurveSnapshot>& sources,
+                  std::vector<PointXY>& output) override;
+
+private:
+    size_t window_;
+    RingBuffer<float> values_;
+    double sum_;
+    // Samples added to sum_ since it was last computed from scratch, to
+    // bound the rounding errors
+    size_t accumulated_;
+};
+
+/**
+ * Amplitude spectrum of the last samples of the source, computed with a
+ * radix-2 FFT. The x coordinates are the frequencies, in cycles per unit of
+ * the source's x coordinates, the sampling period being the mean distance
+ * between the samples. Evaluated again each time the source changes.
+ */
+class SpectrumCurve : public DerivedCurve {
+public:
+    /**
+     * @param source  the index of the source curve
+     * @param samples the number of samples to transform. Must be a power of
+     * two greater than one.
+     */
+    SpectrumCurve(int source, size_t samples);
+
+    size_t memoryUsage() const override;
+
+protected:
+    void reset() override;
+    bool evaluate(const std::vector<CurveSnapshot>& sources,
+                  std::vector<PointXY>& output) override;
+
+private:
+    void transform();
+
+    size_t samples_;
+    std::vector<PointXY> window_;
+    std::vector<std::complex<float>> spectrum_;
+    // exp(-2i*pi*k/samples_) for k in [0, samples_/2[
+    std::vector<std::complex<float>> twiddles_;
+};
+
+} // namespace rtp
@@ -0,0 +1,109 @@
+/*      File: frame_profiler.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <rtplot/metrics.h>
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// The profiling macros expand to nothing unless the library is built with the
+// ENABLE_FRAME_PROFILER CMake option
+#ifdef RTPLOT_FRAME_PROFILER
+#define RTPLOT_PROFILE_PHASE(profiler, phase)                                  \
+    rtp::ScopedPhaseTimer rtplot_phase_timer(profiler, phase)
+#define RTPLOT_PROFILE_CURVE(profiler, curve)                                  \
+    rtp::ScopedCurveTimer rtplot_curve_timer(profiler, curve)
+#else
+#define RTPLOT_PROFILE_PHASE(profiler, phase)
+#define RTPLOT_PROFILE_CURVE(profiler, curve)
+#endif
+
+namespace rtp {
+
+/**
+ * Keep the last durations of a given measurement to compute their mean and
+ * 99th percentile.
+ */
+class RollingTimings {
+public:
+    explicit RollingTimings(size_t window = 256);
+
+    void record(std::chrono::nanoseconds duration);
+
+    PhaseTimings read() const;
+
+private:
+    std::vector<uint64_t> samples_;
+    size_t next_;
+    size_t count_;
+};
+
+/**
+ * Collect the durations of the drawPlot() phases and of each curve drawing.
+ */
+class FrameProfiler {
+public:
+    void record(FramePhase phase, std::chrono::nanoseconds duration);
+
+    void recordCurve(int curve, std::chrono::nanoseconds duration);
+
+    FrameProfile read() const;
+
+private:
+    mutable std::mutex lock_;
+    std::array<RollingTimings, frame_phase_count> phases_;
+    std::map<int, RollingTimings> curves_;
+};
+
+/**
+ * Record the time spent inside a scope as a drawing phase. Does nothing if
+ * the profiler is null.
+ */
+class ScopedPhaseTimer {
+public:
+    ScopedPhaseTimer(FrameProfiler* profiler, FramePhase phase);
+    ~ScopedPhaseTimer();
+
+private:
+    FrameProfiler* profiler_;
+    FramePhase phase_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Record the time spent inside a scope as the drawing of a curve. Does
+ * nothing if the profiler is null.
+ */
+class ScopedCurveTimer {
+public:
+    ScopedCurveTimer(FrameProfiler* profiler, int curve);
+    ~ScopedCurveTimer();
+
+private:
+    FrameProfiler* profiler_;
+    int curve_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace rtp
@@ -0,0 +1,114 @@
+/*      File: point_grid.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rtp {
+
+/**
+ * Spatial hash of the samples of a curve, used to find the sample closest to
+ * a position on curves whose x coordinates are not increasing.
+ *
+ * Samples are identified by their position since the curve's content was last
+ * replaced (see CurveData::first_sample). Removed samples are not erased but
+ * skipped by the lookups, the grid being rebuilt once they are too numerous.
+ */
+class PointGrid {
+public:
+    using PointXY = std::pair<float, float>;
+
+    /**
+     * Create an empty grid
+     * @param cell_size the width and height of the cells, in the samples'
+     * coordinates
+     * @param samples   the number of samples the cells have been sized for
+     */
+    PointGrid(const PointXY& cell_size, size_t samples);
+
+    /**
+     * Add a sample to the grid
+     * @param sample the sample's position in the curve
+     * @param point  the sample's coordinates
+     */
+    void insert(uint64_t sample, const PointXY& point);
+
+    /**
+     * Find the sample closest to a position. Distances are computed after
+     * scaling the x and y differences by the given factors, e.g to measure
+     * them in pixels.
+     * @param position     the reference position
+     * @param scale        the x and y scaling factors
+     * @param first_sample the samples before this one are ignored
+     * @param max_distance the samples further away are ignored
+     * @param[out] nearest the closest sample's coordinates
+     * @return true if a sample has been found
+     */
+    bool nearest(const PointXY& position, const PointXY& scale,
+                 uint64_t first_sample, float max_distance,
+                 PointXY& nearest) const;
+
+    /**
+     * Tell if the grid should be rebuilt, either because most of its samples
+     * have been removed or because the cells became too crowded
+     * @param samples the number of samples currently stored in the curve
+     * @return true if the grid is outdated
+     */
+    bool outdated(size_t samples) const;
+
+    /**
+     * Number of bytes allocated for the cells
+     * @return the size in bytes
+     */
+    size_t memoryUsage() const;
+
+private:
+    struct Entry {
+        uint64_t sample;
+        PointXY point;
+    };
+
+    using Cell = std::pair<int32_t, int32_t>;
+
+    struct CellHash {
+        size_t operator()(const Cell& cell) const {
+            return std::hash<uint64_t>()(uint64_t(uint32_t(cell.first)) << 32 |
+                                         uint32_t(cell.second));
+        }
+    };
+
+    Cell cellOf(const PointXY& point) const;
+
+    PointXY cell_size_;
+    std::unordered_map<Cell, std::vector<Entry>, CellHash> cells_;
+    // Bounds of the non empty cells
+    Cell min_cell_;
+    Cell max_cell_;
+    // Number of samples inserted, including the removed ones
+    size_t size_;
+    size_t initial_samples_;
+};
+
+} // namespace rtp
@@ -0,0 +1,94 @@
+/*      File: polyline_clipper.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <rtplot/internal/render_command_buffer.h>
+
+namespace rtp {
+
+/**
+ * Record polylines into a RenderCommandBuffer after clipping them to a
+ * rectangle and merging the points that don't change the line by more than a
+ * sub-pixel tolerance.
+ *
+ * Segments are clipped using the Liang-Barsky algorithm and the polyline is
+ * split each time it leaves the rectangle. Successive points are merged as
+ * long as they stay within the tolerance of the line going through the last
+ * recorded point and keep moving in the same direction, so spikes and
+ * direction changes are always preserved.
+ */
+class PolylineClipper {
+public:
+    using PointXY = RenderCommandBuffer::PointXY;
+
+    /**
+     * Create a clipper recording in the given buffer
+     * @param commands the buffer receiving the polylines
+     */
+    explicit PolylineClipper(RenderCommandBuffer& commands);
+
+    /**
+     * Start a new line
+     * @param start     the top left corner of the clipping rectangle
+     * @param size      the size of the clipping rectangle
+     * @param tolerance the maximum distance, in pixels, between a merged
+     * point and the recorded line
+     */
+    void begin(const PointXY& start, const PointXY& size, float tolerance);
+
+    /**
+     * Add a point to the current line. Non finite points interrupt the line.
+     * @param point the point's coordinates
+     */
+    void addPoint(const PointXY& point);
+
+    /**
+     * Record the pending points of the current line
+     */
+    void end();
+
+private:
+    bool clip(PointXY& start, PointXY& end) const;
+    void openPolyline(const PointXY& point);
+    void closePolyline();
+    void merge(const PointXY& point);
+
+    RenderCommandBuffer& commands_;
+    PointXY min_;
+    PointXY max_;
+    float tolerance_;
+
+    // Last point given to addPoint() and end of the last recorded segment
+    PointXY previous_;
+    PointXY end_of_line_;
+    bool has_previous_;
+
+    // Last point recorded in the buffer, the end of the current run of merged
+    // points and the run's direction
+    PointXY anchor_;
+    PointXY pending_;
+    PointXY direction_;
+    float pending_distance_;
+    bool has_pending_;
+    bool has_direction_;
+    bool is_open_;
+};
+
+} // namespace rtp
@@ -0,0 +1,79 @@
+/*      File: priority_mutex.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <pthread.h>
+
+#include <system_error>
+
+namespace rtp {
+
+/**
+ * Mutex protecting data shared between real time producers and lower
+ * priority threads. It uses priority inheritance: a thread waiting for the
+ * lock raises the holder to its own priority until the lock is released. A
+ * holder preempted by a higher priority waiter on the same CPU therefore
+ * still runs to the end of its critical section instead of being starved.
+ * Uncontended locking and unlocking don't enter the kernel. Satisfies the
+ * Lockable requirements so it can be used with std::lock_guard and
+ * std::unique_lock.
+ */
+class PriorityMutex {
+public:
+    PriorityMutex() {
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_setprotocol(&attributes, PTHREAD_PRIO_INHERIT);
+        int error = pthread_mutex_init(&mutex_, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+        if (error != 0) {
+            throw std::system_error(error, std::generic_category(),
+                                    "Failed to create a mutex");
+        }
+    }
+
+    ~PriorityMutex() {
+        pthread_mutex_destroy(&mutex_);
+    }
+
+    PriorityMutex(const PriorityMutex&) = delete;
+    PriorityMutex& operator=(const PriorityMutex&) = delete;
+
+    void lock() {
+        int error = pthread_mutex_lock(&mutex_);
+        if (error != 0) {
+            throw std::system_error(error, std::generic_category(),
+                                    "Failed to lock a mutex");
+        }
+    }
+
+    bool try_lock() {
+        return pthread_mutex_trylock(&mutex_) == 0;
+    }
+
+    void unlock() {
+        pthread_mutex_unlock(&mutex_);
+    }
+
+private:
+    pthread_mutex_t mutex_;
+};
+
+} // namespace rtp
@@ -0,0 +1,105 @@
+/*      File: refresh_scheduler.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace rtp {
+
+/**
+ * Call a redraw function from a dedicated thread when a refresh has been
+ * requested and/or periodically.
+ *
+ * Requesting a refresh only marks the window as dirty and never blocks. All
+ * the requests made while a redraw is pending or in progress are coalesced
+ * into a single redraw and two redraws are always separated by at least the
+ * minimum interval, capping the frame rate.
+ */
+class RefreshScheduler {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit RefreshScheduler(std::function<void()> redraw);
+    ~RefreshScheduler();
+
+    /**
+     * Start the rendering thread. Refreshes requested before are performed
+     * right away.
+     */
+    void start();
+
+    /**
+     * Stop the rendering thread. Waits for the current redraw to finish.
+     */
+    void stop();
+
+    /**
+     * Mark the window as needing a redraw
+     */
+    void requestRefresh();
+
+    /**
+     * Set the period of the automatic refreshes
+     * @param period the time between two automatic refreshes. Zero disables
+     * them.
+     */
+    void setPeriod(std::chrono::milliseconds period);
+
+    /**
+     * Set the minimum time between two redraws
+     * @param interval the minimum interval
+     */
+    void setMinInterval(std::chrono::microseconds interval);
+
+    /**
+     * Number of redraws performed so far
+     */
+    uint64_t refreshes() const;
+
+    /**
+     * Number of automatic refreshes that couldn't be performed within their
+     * period
+     */
+    uint64_t missedDeadlines() const;
+
+private:
+    void process();
+
+    std::function<void()> redraw_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool dirty_;
+    bool stop_;
+    std::chrono::milliseconds period_;
+    std::chrono::microseconds min_interval_;
+    clock::time_point last_redraw_;
+    clock::time_point next_periodic_redraw_;
+    std::atomic<uint64_t> refreshes_;
+    std::atomic<uint64_t> missed_deadlines_;
+};
+
+} // namespace rtp
@@ -0,0 +1,148 @@
+/*      File: render_command_buffer.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <rtplot/colors.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rtp {
+
+/**
+ * Compact list of drawing commands recorded by RTPlotCore and replayed later
+ * on the GUI thread.
+ *
+ * All the storage is kept between frames, so once the buffer has grown to its
+ * working size recording a new frame doesn't allocate anymore.
+ */
+class RenderCommandBuffer {
+public:
+    using PointXY = std::pair<float, float>;
+
+    enum class Op : uint8_t {
+        PushClip,     // points[index]: start, points[index+1]: size
+        PopClip,      //
+        StartLine,    //
+        Polyline,     // points[index, index+count[: the line's points
+        EndLine,      //
+        SetLineStyle, // arg: the style
+        SetColor,     // arg: the color
+        SaveColor,    //
+        RestoreColor, //
+        DrawText,     // texts[count], arg: angle, points[index]: position,
+                      // points[index+1]: offset in text widths,
+                      // points[index+2]: offset in text heights
+        DrawImage     // images[count], points[index]: position,
+                      // points[index+1]: width and height
+    };
+
+    struct Command {
+        Op op;
+        int32_t arg;
+        uint32_t index;
+        uint32_t count;
+    };
+
+    RenderCommandBuffer();
+
+    /**
+     * Remove all the commands while keeping the allocated memory
+     */
+    void clear();
+
+    void pushClip(const PointXY& start, const PointXY& size);
+    void popClip();
+    void startLine();
+    void endLine();
+    void setLineStyle(int style);
+    void setColor(Colors color);
+    void saveColor();
+    void restoreColor();
+
+    /**
+     * Draw a single line segment
+     * @param start the coordinates of the starting point
+     * @param end   the coordinates of the ending point
+     */
+    void line(const PointXY& start, const PointXY& end);
+
+    /**
+     * Start a new polyline. Its points are then given using addPoint()
+     */
+    void beginPolyline();
+
+    /**
+     * Add a point to the current polyline
+     * @param point the point's coordinates
+     */
+    void addPoint(const PointXY& point);
+
+    /**
+     * Draw a text. The final position is computed at replay time, when the
+     * text can be measured, as position + width * width_offset + height *
+     * height_offset.
+     * @param text          the text to draw
+     * @param position      the reference position of the text
+     * @param width_offset  offset expressed as a fraction of the text width
+     * @param height_offset offset expressed as a fraction of the text height
+     * @param angle         the text angle in degrees
+     */
+    void text(const std::string& text, const PointXY& position,
+              const PointXY& width_offset = PointXY{0.f, 0.f},
+              const PointXY& height_offset = PointXY{0.f, 0.f},
+              int angle = 0);
+
+    /**
+     * Draw an 8 bits intensity image
+     * @param position the top left corner of the image
+     * @param width    the width of the image in pixels
+     * @param height   the height of the image in pixels
+     * @return the storage for the image's width * height intensities, row by
+     * row, to fill by the caller
+     */
+    uint8_t* image(const PointXY& position, size_t width, size_t height);
+
+    const std::vector<Command>& commands() const;
+    const std::vector<PointXY>& points() const;
+    const std::string& text(size_t index) const;
+    const uint8_t* image(size_t index) const;
+
+    /**
+     * Number of bytes allocated by the buffer
+     * @return the size in bytes
+     */
+    size_t memoryUsage() const;
+
+private:
+    void add(Op op, int32_t arg = 0, uint32_t index = 0, uint32_t count = 0);
+
+    std::vector<Command> commands_;
+    std::vector<PointXY> points_;
+    std::vector<std::string> texts_;
+    size_t text_count_;
+    std::vector<std::vector<uint8_t>> images_;
+    size_t image_count_;
+};
+
+} // namespace rtp
@@ -0,0 +1,133 @@
+/*      File: ring_buffer.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace rtp {
+
+/**
+ * FIFO container with contiguous, power of two sized, storage. Unlike
+ * std::deque, pushing and popping elements never allocates once the buffer
+ * has grown large enough or has been reserved.
+ */
+template <typename T> class RingBuffer {
+public:
+    RingBuffer() : first_(0), size_(0) {
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_t capacity() const {
+        return storage_.size();
+    }
+
+    T& operator[](size_t idx) {
+        return storage_[(first_ + idx) & (storage_.size() - 1)];
+    }
+
+    const T& operator[](size_t idx) const {
+        return storage_[(first_ + idx) & (storage_.size() - 1)];
+    }
+
+    T& front() {
+        return (*this)[0];
+    }
+
+    const T& front() const {
+        return (*this)[0];
+    }
+
+    T& back() {
+        return (*this)[size_ - 1];
+    }
+
+    const T& back() const {
+        return (*this)[size_ - 1];
+    }
+
+    /**
+     * Make sure that count elements can be stored without allocating
+     * @param count the number of elements
+     */
+    void reserve(size_t count) {
+        if (count > storage_.size()) {
+            grow(count);
+        }
+    }
+
+    void push_back(T value) {
+        if (size_ == storage_.size()) {
+            grow(size_ + 1);
+        }
+        (*this)[size_] = std::move(value);
+        ++size_;
+    }
+
+    void pop_front() {
+        front() = T();
+        first_ = (first_ + 1) & (storage_.size() - 1);
+        --size_;
+    }
+
+    void pop_back() {
+        back() = T();
+        --size_;
+    }
+
+    /**
+     * Remove all the elements while keeping the allocated memory
+     */
+    void clear() {
+        while (not empty()) {
+            pop_front();
+        }
+        first_ = 0;
+    }
+
+private:
+    void grow(size_t count) {
+        size_t capacity = std::max<size_t>(storage_.size(), 8);
+        while (capacity < count) {
+            capacity *= 2;
+        }
+        std::vector<T> storage(capacity);
+        for (size_t i = 0; i < size_; ++i) {
+            storage[i] = std::move((*this)[i]);
+        }
+        storage_.swap(storage);
+        first_ = 0;
+    }
+
+    std::vector<T> storage_;
+    size_t first_;
+    size_t size_;
+};
+
+} // namespace rtp
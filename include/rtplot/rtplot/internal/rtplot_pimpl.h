@@ -24,16 +24,27 @@
 
 #include <rtplot/internal/rtplot_window.h>
 #include <rtplot/internal/rtplot_layout.h>
+#include <rtplot/internal/refresh_scheduler.h>
+#include <rtplot/internal/worker_pool.h>
 
-#include <thread>
 #include <vector>
 #include <mutex>
+#include <atomic>
 #include <cassert>
 
 namespace rtp {
 
 struct RTPlot::rtplot_members {
-    rtplot_members() : auto_refresh_period_(0), grid_rows_(1), grid_cols_(1) {
+    using PlotPtrs = std::vector<std::atomic<RTPlotCore*>>;
+
+    rtplot_members()
+        : plot_ptrs_(nullptr),
+          grid_rows_(1),
+          grid_cols_(1),
+          min_refresh_interval_us_(0),
+          refresh_slowdown_(1),
+          frame_budget_ms_(0.f),
+          workers_(WorkerPool::defaultThreadCount()) {
     }
 
     ~rtplot_members() = default;
@@ -41,12 +52,30 @@ struct RTPlot::rtplot_members {
     std::unique_ptr<RTPlotWindow> window_;
     std::unique_ptr<RTPlotLayout> layout_;
     std::vector<std::shared_ptr<RTPlotCore>> plots_;
+    // Same as plots_, read without locking to find the existing plots.
+    // Replaced when the grid is resized
+    std::atomic<PlotPtrs*> plot_ptrs_;
+    // The current and previous plot_ptrs_ and the plots removed from the
+    // grid, never freed since producers can still be using them
+    std::vector<std::unique_ptr<PlotPtrs>> plot_ptrs_tables_;
+    std::vector<std::shared_ptr<RTPlotCore>> removed_plots_;
+    // Protects plots_, the grid size and the above against concurrent
+    // creations and resizes
+    std::mutex plots_lock_;
 
-    std::thread auto_refresh_thread_;
-    std::mutex auto_refresh_period_lock_;
-    size_t auto_refresh_period_;
+    std::unique_ptr<RefreshScheduler> scheduler_;
     size_t grid_rows_;
     size_t grid_cols_;
+
+    // Both accessed from the user and rendering threads
+    std::atomic<int64_t> min_refresh_interval_us_;
+    std::atomic<size_t> refresh_slowdown_;
+    // Frame budget of the whole window, used for newly created plots
+    float frame_budget_ms_;
+
+    // Used to prepare the plots' frames in parallel
+    WorkerPool workers_;
+    std::vector<std::shared_ptr<RTPlotCore>> plots_to_prepare_;
 };
 
 } // namespace rtp
@@ -0,0 +1,108 @@
+/*      File: running_statistics.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace rtp {
+
+/**
+ * Mean and variance of a FIFO window of values, updated in constant time when
+ * a value enters or leaves the window.
+ *
+ * Uses Welford's algorithm, extended to the removal of values, which is much
+ * less prone to cancellation than keeping the sums of the values and of
+ * their squares.
+ */
+class RunningStatistics {
+public:
+    RunningStatistics() {
+        clear();
+    }
+
+    /**
+     * Add a value to the window
+     * @param value the value to add
+     */
+    void push(double value) {
+        ++count_;
+        double delta = value - mean_;
+        mean_ += delta / double(count_);
+        m2_ += delta * (value - mean_);
+    }
+
+    /**
+     * Remove a value previously added to the window
+     * @param value the value to remove
+     */
+    void pop(double value) {
+        if (count_ <= 1) {
+            clear();
+            return;
+        }
+        --count_;
+        double delta = value - mean_;
+        mean_ -= delta / double(count_);
+        m2_ = std::max(m2_ - delta * (value - mean_), 0.);
+    }
+
+    /**
+     * Remove all the values
+     */
+    void clear() {
+        count_ = 0;
+        mean_ = 0.;
+        m2_ = 0.;
+    }
+
+    size_t count() const {
+        return count_;
+    }
+
+    double mean() const {
+        return mean_;
+    }
+
+    /**
+     * Population variance of the window
+     * @return the variance, zero if the window is empty
+     */
+    double variance() const {
+        return count_ ? m2_ / double(count_) : 0.;
+    }
+
+    /**
+     * Root mean square of the window
+     * @return the RMS, zero if the window is empty
+     */
+    double rms() const {
+        return std::sqrt(mean_ * mean_ + variance());
+    }
+
+private:
+    size_t count_;
+    double mean_;
+    // Sum of the squared differences to the mean
+    double m2_;
+};
+
+} // namespace rtp
@@ -0,0 +1,167 @@
+/*      File: sample_filter.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <rtplot/ingestion_filter.h>
+
+#include <cstddef>
+
+namespace rtp {
+
+/**
+ * Apply an IngestionFilter to a stream of samples
+ */
+class SampleFilter {
+public:
+    SampleFilter() : type_(IngestionFilter::None), factor_(1) {
+        reset();
+    }
+
+    /**
+     * Change the filter. The current block is discarded.
+     * @param type   the filter to apply
+     * @param factor the number of input samples per block. A factor of one
+     * disables the filtering.
+     */
+    void configure(IngestionFilter type, size_t factor) {
+        type_ = factor > 1 ? type : IngestionFilter::None;
+        factor_ = type_ == IngestionFilter::None ? 1 : factor;
+        reset();
+    }
+
+    IngestionFilter type() const {
+        return type_;
+    }
+
+    /**
+     * Discard the current block
+     */
+    void reset() {
+        count_ = 0;
+        sum_x_ = 0.;
+        sum_y_ = 0.;
+        filtered_ = 0.f;
+        has_filtered_ = false;
+    }
+
+    /**
+     * Distance between two output samples, in input samples. Used to compute
+     * the x coordinates of uniformly sampled curves.
+     * @return the distance
+     */
+    float outputStep() const {
+        return type_ == IngestionFilter::BlockMinMax ? 0.5f * float(factor_)
+                                                     : float(factor_);
+    }
+
+    /**
+     * Position of the first output sample of a block relative to the block's
+     * first input sample, in input samples.
+     * @return the position
+     */
+    float outputOffset() const {
+        switch (type_) {
+        case IngestionFilter::BlockAverage:
+            return 0.5f * float(factor_ - 1);
+        case IngestionFilter::LowPass:
+            return float(factor_ - 1);
+        default:
+            return 0.f;
+        }
+    }
+
+    /**
+     * Process a new input sample
+     * @param x      the x coordinate of the sample
+     * @param y      the y coordinate of the sample
+     * @param output called with the coordinates of each sample to store
+     */
+    template <typename Output> void process(float x, float y, Output&& output) {
+        bool block_end = count_ + 1 == factor_;
+        switch (type_) {
+        case IngestionFilter::None:
+            output(x, y);
+            break;
+        case IngestionFilter::KeepNth:
+            if (count_ == 0) {
+                output(x, y);
+            }
+            break;
+        case IngestionFilter::BlockAverage:
+            sum_x_ += x;
+            sum_y_ += y;
+            if (block_end) {
+                output(float(sum_x_ / double(factor_)),
+                       float(sum_y_ / double(factor_)));
+                sum_x_ = 0.;
+                sum_y_ = 0.;
+            }
+            break;
+        case IngestionFilter::BlockMinMax:
+            if (count_ == 0 or y < min_y_) {
+                min_x_ = x;
+                min_y_ = y;
+                min_idx_ = count_;
+            }
+            if (count_ == 0 or y > max_y_) {
+                max_x_ = x;
+                max_y_ = y;
+                max_idx_ = count_;
+            }
+            if (block_end) {
+                if (min_idx_ <= max_idx_) {
+                    output(min_x_, min_y_);
+                    output(max_x_, max_y_);
+                } else {
+                    output(max_x_, max_y_);
+                    output(min_x_, min_y_);
+                }
+            }
+            break;
+        case IngestionFilter::LowPass:
+            if (has_filtered_) {
+                filtered_ += (y - filtered_) / float(factor_);
+            } else {
+                filtered_ = y;
+                has_filtered_ = true;
+            }
+            if (block_end) {
+                output(x, filtered_);
+            }
+            break;
+        }
+        count_ = block_end ? 0 : count_ + 1;
+    }
+
+private:
+    IngestionFilter type_;
+    size_t factor_;
+    // Position of the next input sample in the current block
+    size_t count_;
+    double sum_x_;
+    double sum_y_;
+    float min_x_, min_y_;
+    float max_x_, max_y_;
+    size_t min_idx_, max_idx_;
+    float filtered_;
+    bool has_filtered_;
+};
+
+} // namespace rtp
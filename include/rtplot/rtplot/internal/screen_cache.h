@@ -0,0 +1,103 @@
+/*      File: screen_cache.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <rtplot/internal/ring_buffer.h>
+
+#include <cstdint>
+#include <utility>
+
+namespace rtp {
+
+/**
+ * Screen coordinates of a contiguous range of a curve's samples. Samples are
+ * identified by their position since the curve's content was last replaced
+ * (see CurveData::first_sample and CurveData::generation) so that the
+ * coordinates computed during a frame can be reused by the next ones as long
+ * as the plot's transform doesn't change. Only the new samples then have to
+ * be transformed.
+ */
+class ScreenCache {
+public:
+    using PointXY = std::pair<float, float>;
+
+    ScreenCache() : generation_(0), first_(0) {
+    }
+
+    /**
+     * Number of bytes allocated for the coordinates
+     * @return the size in bytes
+     */
+    size_t memoryUsage() const {
+        return points_.capacity() * sizeof(PointXY);
+    }
+
+    /**
+     * Remove all the cached coordinates, e.g when the transform changes
+     */
+    void clear() {
+        points_.clear();
+        generation_ = 0;
+        first_ = 0;
+    }
+
+    /**
+     * Make the cache hold the coordinates of the samples in [first,last[.
+     * Older samples are dropped and the missing ones transformed.
+     * @param generation the generation of the curve's content
+     * @param first      the first sample needed
+     * @param last       the sample following the last one needed
+     * @param transform  callable giving the screen coordinates of a sample
+     */
+    template <typename Transform>
+    void update(uint64_t generation, uint64_t first, uint64_t last,
+                Transform&& transform) {
+        if (generation != generation_ or first < first_ or
+            first > first_ + points_.size()) {
+            points_.clear();
+            generation_ = generation;
+            first_ = first;
+        }
+        while (first_ < first) {
+            points_.pop_front();
+            ++first_;
+        }
+        for (uint64_t sample = first_ + points_.size(); sample < last;
+             ++sample) {
+            points_.push_back(transform(sample));
+        }
+    }
+
+    /**
+     * Screen coordinates of a sample previously given to update()
+     * @param sample the sample's position
+     * @return the coordinates
+     */
+    const PointXY& operator[](uint64_t sample) const {
+        return points_[size_t(sample - first_)];
+    }
+
+private:
+    RingBuffer<PointXY> points_;
+    uint64_t generation_;
+    uint64_t first_;
+};
+
+} // namespace rtp
@@ -0,0 +1,361 @@
+/*      File: segmented_buffer.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <rtplot/internal/ring_buffer.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace rtp {
+
+/**
+ * FIFO container storing its elements inside fixed size, reference counted
+ * segments.
+ *
+ * Taking a snapshot of the buffer only copies the segments' pointers, so the
+ * snapshot can be read later without holding any lock while elements are
+ * still appended to (or removed from) the buffer. Appending never modifies the
+ * elements already visible to a snapshot and removed segments stay alive as
+ * long as a snapshot references them.
+ *
+ * Released segments are kept in a pool and reused once no snapshot references
+ * them anymore. After a call to reserve(), appending and removing elements
+ * doesn't allocate as long as at most one snapshot is kept for long.
+ */
+template <typename T, size_t SegmentSize = 512> class SegmentedBuffer {
+public:
+    static_assert((SegmentSize & (SegmentSize - 1)) == 0,
+                  "SegmentSize must be a power of two");
+
+    struct Segment {
+        std::array<T, SegmentSize> data;
+    };
+
+    /**
+     * Forward iterator usable on both the buffer and its views.
+     */
+    template <typename Container> class Iterator {
+    public:
+        Iterator(const Container* container, size_t index)
+            : container_(container), index_(index) {
+        }
+
+        const T& operator*() const {
+            return (*container_)[index_];
+        }
+
+        const T* operator->() const {
+            return &(*container_)[index_];
+        }
+
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return index_ == other.index_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return index_ != other.index_;
+        }
+
+    private:
+        const Container* container_;
+        size_t index_;
+    };
+
+    /**
+     * Immutable view on the content of a SegmentedBuffer at a given time.
+     */
+    class View {
+    public:
+        using const_iterator = Iterator<View>;
+
+        View() : first_(0), size_(0) {
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        const T& operator[](size_t idx) const {
+            idx += first_;
+            return segments_[idx / SegmentSize]->data[idx % SegmentSize];
+        }
+
+        const T& front() const {
+            return (*this)[0];
+        }
+
+        const T& back() const {
+            return (*this)[size_ - 1];
+        }
+
+        const_iterator begin() const {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator end() const {
+            return const_iterator(this, size_);
+        }
+
+        /**
+         * Number of bytes allocated for the view itself, the segments being
+         * owned by the buffer
+         * @return the size in bytes
+         */
+        size_t memoryUsage() const {
+            return segments_.capacity() *
+                   sizeof(std::shared_ptr<const Segment>);
+        }
+
+        /**
+         * Release the referenced segments
+         */
+        void clear() {
+            segments_.clear();
+            first_ = 0;
+            size_ = 0;
+        }
+
+    private:
+        friend class SegmentedBuffer;
+
+        std::vector<std::shared_ptr<const Segment>> segments_;
+        size_t first_;
+        size_t size_;
+    };
+
+    using const_iterator = Iterator<SegmentedBuffer>;
+
+    SegmentedBuffer()
+        : max_spare_segments_(default_spare_segments),
+          reserved_segments_(0),
+          first_(0),
+          size_(0) {
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    const T& operator[](size_t idx) const {
+        idx += first_;
+        return segments_[idx / SegmentSize]->data[idx % SegmentSize];
+    }
+
+    const T& front() const {
+        return (*this)[0];
+    }
+
+    const T& back() const {
+        return (*this)[size_ - 1];
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, size_);
+    }
+
+    /**
+     * Number of bytes allocated for the elements storage, including the
+     * pooled segments
+     * @return the size in bytes
+     */
+    size_t memoryUsage() const {
+        return (segments_.size() + spare_.size()) * sizeof(Segment) +
+               (segments_.capacity() + spare_.capacity()) * sizeof(SegmentPtr);
+    }
+
+    /**
+     * Tell if the oldest elements are still referenced by a snapshot, in
+     * which case removing them doesn't free their storage
+     * @return true if the first segment is shared
+     */
+    bool frontShared() const {
+        return not segments_.empty() and segments_.front().use_count() > 1;
+    }
+
+    /**
+     * Tell if all the allocated segments are part of the storage set aside by
+     * reserve(), in which case releaseSpare() can't free anything
+     * @return true if the storage is reserved and not exceeded
+     */
+    bool withinReserve() const {
+        return reserved_segments_ > 0 and
+               segments_.size() + spare_.size() <= reserved_segments_;
+    }
+
+    /**
+     * Free the pooled segments exceeding the reserved storage (see
+     * reserve()), e.g when memory is scarce. Appending elements beyond the
+     * reserved count can allocate again afterwards.
+     */
+    void releaseSpare() {
+        while (not spare_.empty() and
+               segments_.size() + spare_.size() > reserved_segments_) {
+            spare_.pop_back();
+        }
+        max_spare_segments_ =
+            std::max(size_t(default_spare_segments), reserved_segments_);
+    }
+
+    /**
+     * Allocate all the memory needed to store count elements and enlarge the
+     * segments pool accordingly. The pool can also replace all the segments
+     * referenced by one long lived snapshot, e.g the one of a frozen plot.
+     * @param count the number of elements
+     */
+    void reserve(size_t count) {
+        // Partially filled segments at both ends, twice to keep appending
+        // while a snapshot references all of them, plus the ones referenced
+        // by the short lived snapshots
+        size_t segments = 2 * (count / SegmentSize + 2) + snapshot_segments;
+        reserved_segments_ = std::max(reserved_segments_, segments);
+        segments_.reserve(segments);
+        max_spare_segments_ = std::max(max_spare_segments_, segments);
+        spare_.reserve(max_spare_segments_);
+        while (segments_.size() + spare_.size() < segments) {
+            spare_.push_back(std::make_shared<Segment>());
+        }
+    }
+
+    /**
+     * Append an element at the end of the buffer
+     * @param value the element to append
+     */
+    void push_back(const T& value) {
+        size_t idx = first_ + size_;
+        if (idx == segments_.size() * SegmentSize) {
+            segments_.push_back(makeSegment());
+        }
+        segments_[idx / SegmentSize]->data[idx % SegmentSize] = value;
+        ++size_;
+    }
+
+    /**
+     * Remove the first element of the buffer. The buffer must not be empty.
+     */
+    void pop_front() {
+        assert(size_ > 0);
+        ++first_;
+        --size_;
+        if (first_ == SegmentSize) {
+            releaseSegment(std::move(segments_.front()));
+            segments_.pop_front();
+            first_ = 0;
+        }
+    }
+
+    /**
+     * Remove all the elements from the buffer
+     */
+    void clear() {
+        while (not segments_.empty()) {
+            releaseSegment(std::move(segments_.front()));
+            segments_.pop_front();
+        }
+        first_ = 0;
+        size_ = 0;
+    }
+
+    /**
+     * Fill a view with the current content of the buffer. The view's storage
+     * is reused so no allocation happens once it has grown large enough.
+     * @param view the view to fill
+     */
+    void snapshot(View& view) const {
+        view.segments_.resize(segments_.size());
+        for (size_t i = 0; i < segments_.size(); ++i) {
+            view.segments_[i] = segments_[i];
+        }
+        view.first_ = first_;
+        view.size_ = size_;
+    }
+
+private:
+    using SegmentPtr = std::shared_ptr<Segment>;
+
+    /**
+     * Number of released segments kept around by default to avoid
+     * allocations
+     */
+    static constexpr size_t default_spare_segments = 2;
+
+    /**
+     * Segments reserved for the short lived snapshots, e.g the ones taken to
+     * build a frame, in addition to the ones needed to store the elements
+     */
+    static constexpr size_t snapshot_segments = 4;
+
+    SegmentPtr makeSegment() {
+        // A segment can only be reused if no snapshot references it anymore.
+        // The fence pairs with the release performed by the snapshot's
+        // shared_ptr destructor so that its last reads happen before our next
+        // writes
+        for (size_t i = spare_.size(); i > 0; --i) {
+            if (spare_[i - 1].use_count() == 1) {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                std::swap(spare_[i - 1], spare_.back());
+                auto segment = std::move(spare_.back());
+                spare_.pop_back();
+                return segment;
+            }
+        }
+        return std::make_shared<Segment>();
+    }
+
+    void releaseSegment(SegmentPtr segment) {
+        // Segments still referenced by a snapshot are kept in the pool too so
+        // that they can be reused once the snapshot is released
+        if (spare_.size() < max_spare_segments_) {
+            spare_.push_back(std::move(segment));
+        }
+    }
+
+    RingBuffer<SegmentPtr> segments_;
+    std::vector<SegmentPtr> spare_;
+    size_t max_spare_segments_;
+    // Segments allocated by reserve(), kept by releaseSpare()
+    size_t reserved_segments_;
+    size_t first_;
+    size_t size_;
+};
+
+} // namespace rtp
@@ -0,0 +1,132 @@
+/*      File: sliding_extrema.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <rtplot/internal/ring_buffer.h>
+
+#include <cstdint>
+
+namespace rtp {
+
+/**
+ * Minimum and maximum of a FIFO window of values, in amortized constant time.
+ *
+ * Uses the monotonic wedge algorithm: only the values that can still become
+ * the minimum (resp. maximum) of the window, i.e. the ones not followed by a
+ * smaller (resp. greater) value, are kept, in order.
+ */
+class SlidingExtrema {
+public:
+    SlidingExtrema() : pushed_(0), popped_(0) {
+    }
+
+    /**
+     * Add a value at the end of the window
+     * @param value the value to add
+     */
+    void push(float value) {
+        while (not min_.empty() and min_.back().value > value) {
+            min_.pop_back();
+        }
+        min_.push_back(Entry{value, pushed_});
+        while (not max_.empty() and max_.back().value < value) {
+            max_.pop_back();
+        }
+        max_.push_back(Entry{value, pushed_});
+        ++pushed_;
+    }
+
+    /**
+     * Remove the oldest value of the window. Does nothing if the window is
+     * empty.
+     */
+    void pop() {
+        if (empty()) {
+            return;
+        }
+        if (min_.front().index == popped_) {
+            min_.pop_front();
+        }
+        if (max_.front().index == popped_) {
+            max_.pop_front();
+        }
+        ++popped_;
+    }
+
+    bool empty() const {
+        return pushed_ == popped_;
+    }
+
+    /**
+     * Smallest value of the window. The window must not be empty.
+     * @return the minimum
+     */
+    float min() const {
+        return min_.front().value;
+    }
+
+    /**
+     * Greatest value of the window. The window must not be empty.
+     * @return the maximum
+     */
+    float max() const {
+        return max_.front().value;
+    }
+
+    /**
+     * Remove all the values while keeping the allocated memory
+     */
+    void clear() {
+        min_.clear();
+        max_.clear();
+        pushed_ = popped_ = 0;
+    }
+
+    /**
+     * Make sure that a window of count values can be handled without
+     * allocating
+     * @param count the number of values
+     */
+    void reserve(size_t count) {
+        min_.reserve(count);
+        max_.reserve(count);
+    }
+
+    /**
+     * Number of bytes allocated
+     * @return the size in bytes
+     */
+    size_t memoryUsage() const {
+        return (min_.capacity() + max_.capacity()) * sizeof(Entry);
+    }
+
+private:
+    struct Entry {
+        float value;
+        uint64_t index;
+    };
+
+    RingBuffer<Entry> min_;
+    RingBuffer<Entry> max_;
+    uint64_t pushed_;
+    uint64_t popped_;
+};
+
+} // namespace rtp
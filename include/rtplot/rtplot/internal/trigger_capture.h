@@ -0,0 +1,172 @@
+/*      File: trigger_capture.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <rtplot/trigger_mode.h>
+#include <rtplot/internal/ring_buffer.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace rtp {
+
+/**
+ * Window of samples captured around a trigger event. Immutable once the
+ * capture is complete.
+ */
+struct TriggerSweep {
+    using PointXY = std::pair<float, float>;
+
+    // Samples preceding the trigger, the triggering one and the following
+    // ones
+    std::vector<PointXY> points;
+    // Position of the triggering sample in points, i.e the number of samples
+    // captured before it, fewer than requested if the history was shorter
+    size_t trigger_index;
+    // x coordinate of the triggering sample, the sweeps being overlaid
+    // relative to it
+    float trigger_x;
+    // Bounds of the samples, the x ones being relative to trigger_x
+    float xmin, xmax;
+    float ymin, ymax;
+};
+
+/**
+ * Detect trigger events in a stream of samples and capture the samples
+ * around them, like an oscilloscope. The detection costs a comparison per
+ * sample. Starting a capture copies the pre-trigger samples; each of the
+ * following ones is then appended to the capture. No other trigger is
+ * detected until the capture is complete.
+ *
+ * The last completed sweeps are retained. Their storage comes from a pool,
+ * allocated upfront, and is reused once a sweep has been dropped and no
+ * snapshot references it anymore, so captures don't allocate as long as at
+ * most one snapshot is kept for long.
+ */
+class TriggerCapture {
+public:
+    using PointXY = std::pair<float, float>;
+
+    /**
+     * Create a capture, armed
+     * @param mode         the trigger condition
+     * @param level        the value the condition is evaluated against
+     * @param pre_samples  the number of samples kept before the trigger
+     * @param post_samples the number of samples kept after the trigger
+     * @param max_sweeps   the number of completed sweeps retained
+     */
+    TriggerCapture(TriggerMode mode, float level, size_t pre_samples,
+                   size_t post_samples, size_t max_sweeps);
+
+    /**
+     * Process a new sample
+     * @param x the x coordinate of the sample
+     * @param y the y coordinate of the sample
+     */
+    void process(float x, float y) {
+        if (capture_) {
+            append(x, y);
+        } else if (triggered(y)) {
+            start(x, y);
+        }
+        if (pre_samples_ > 0) {
+            if (history_.size() == pre_samples_) {
+                history_.pop_front();
+            }
+            history_.push_back(PointXY(x, y));
+        }
+        previous_y_ = y;
+        has_previous_ = true;
+    }
+
+    /**
+     * Discard the samples seen so far and the capture in progress, e.g when
+     * the curve's content is replaced. The retained sweeps are kept.
+     */
+    void reset();
+
+    /**
+     * The completed sweeps, oldest first
+     * @return the sweeps
+     */
+    const RingBuffer<std::shared_ptr<TriggerSweep>>& sweeps() const {
+        return sweeps_;
+    }
+
+    /**
+     * Number of captures completed since the trigger has been set
+     * @return the number of captures
+     */
+    uint64_t captures() const {
+        return captures_;
+    }
+
+    /**
+     * Number of bytes allocated for the history and the sweeps, including
+     * the pooled ones
+     * @return the size in bytes
+     */
+    size_t memoryUsage() const;
+
+private:
+    bool triggered(float y) const {
+        switch (mode_) {
+        case TriggerMode::RisingEdge:
+            return has_previous_ and previous_y_ < level_ and y >= level_;
+        case TriggerMode::FallingEdge:
+            return has_previous_ and previous_y_ > level_ and y <= level_;
+        case TriggerMode::Threshold:
+            return y >= level_;
+        }
+        return false;
+    }
+
+    void start(float x, float y);
+    void add(float x, float y);
+    void append(float x, float y);
+    void complete();
+    std::shared_ptr<TriggerSweep> makeSweep();
+    void release(std::shared_ptr<TriggerSweep> sweep);
+
+    TriggerMode mode_;
+    float level_;
+    size_t pre_samples_;
+    size_t post_samples_;
+    size_t max_sweeps_;
+    // Last pre_samples_ samples
+    RingBuffer<PointXY> history_;
+    float previous_y_;
+    bool has_previous_;
+    // Sweep being filled, null while waiting for a trigger
+    std::shared_ptr<TriggerSweep> capture_;
+    RingBuffer<std::shared_ptr<TriggerSweep>> sweeps_;
+    // Dropped sweeps, possibly still referenced by a snapshot
+    std::vector<std::shared_ptr<TriggerSweep>> spare_;
+    // Number of sweeps allocated upfront: the retained ones can all be
+    // referenced by a long lived snapshot, e.g the one of a frozen plot,
+    // while as many new ones are captured
+    size_t pool_size_;
+    uint64_t captures_;
+};
+
+} // namespace rtp
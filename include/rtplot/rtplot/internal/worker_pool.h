@@ -0,0 +1,77 @@
+/*      File: worker_pool.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rtp {
+
+/**
+ * Small pool of persistent threads used to run independent tasks in
+ * parallel.
+ */
+class WorkerPool {
+public:
+    /**
+     * Create the pool
+     * @param threads number of worker threads. The calling thread also takes
+     * part in the work so zero is valid and runs everything sequentially.
+     */
+    explicit WorkerPool(size_t threads);
+    ~WorkerPool();
+
+    /**
+     * Call task(i) for each i in [0, count[ and wait for all the calls to
+     * complete. Must not be called concurrently.
+     * @param count number of tasks
+     * @param task  the function to call
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+    /**
+     * Default number of worker threads: one less than the number of cores,
+     * with a maximum of four.
+     */
+    static size_t defaultThreadCount();
+
+private:
+    void process();
+
+    // Run the remaining tasks of the current job. Called with lock_ held
+    void runTasks(std::unique_lock<std::mutex>& lock);
+
+    std::vector<std::thread> threads_;
+    std::mutex lock_;
+    std::condition_variable work_available_;
+    std::condition_variable work_done_;
+    const std::function<void(size_t)>* task_;
+    size_t task_count_;
+    size_t next_task_;
+    size_t pending_tasks_;
+    size_t generation_;
+    bool stop_;
+};
+
+} // namespace rtp
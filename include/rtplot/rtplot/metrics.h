@@ -0,0 +1,231 @@
+/*      File: metrics.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <vector>
+
+namespace rtp {
+
+/**
+ * Distribution of durations using power of two buckets. Bucket i holds the
+ * durations in the [2^i, 2^(i+1)[ nanoseconds interval, bucket 0 also holding
+ * the null durations.
+ */
+struct DurationDistribution {
+    static constexpr size_t bucket_count = 40;
+
+    DurationDistribution();
+
+    /**
+     * Mean duration
+     * @return the mean duration in nanoseconds
+     */
+    double mean() const;
+
+    /**
+     * Approximate percentile. The upper bound of the bucket containing the
+     * percentile is returned.
+     * @param  ratio the percentile to compute, in the [0,1] interval
+     * @return       the duration in nanoseconds
+     */
+    uint64_t percentile(double ratio) const;
+
+    std::array<uint64_t, bucket_count> buckets;
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+};
+
+/**
+ * Record durations into a DurationDistribution. Can be used concurrently from
+ * multiple threads, all operations are relaxed atomics.
+ */
+class DurationHistogram {
+public:
+    DurationHistogram();
+
+    /**
+     * Add a new duration to the histogram
+     * @param duration the duration to record
+     */
+    void record(std::chrono::nanoseconds duration);
+
+    /**
+     * Read the current distribution
+     * @return the distribution
+     */
+    DurationDistribution read() const;
+
+    /**
+     * Remove all the recorded durations
+     */
+    void reset();
+
+private:
+    std::array<std::atomic<uint64_t>, DurationDistribution::bucket_count>
+        buckets_;
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> total_ns_;
+    std::atomic<uint64_t> max_ns_;
+};
+
+/**
+ * Bytes allocated for a curve, a plot or a set of plots, by purpose. The
+ * storage shared with snapshots still in use is only accounted for by its
+ * owner.
+ */
+struct MemoryUsage {
+    MemoryUsage();
+
+    /**
+     * Total number of bytes
+     * @return the size in bytes
+     */
+    size_t total() const;
+
+    MemoryUsage& operator+=(const MemoryUsage& other);
+
+    // Uncompressed samples, including the pooled storage
+    size_t samples;
+    // Compressed samples and the compression buffers
+    size_t compressed;
+    // Extrema, trigger captures and age of the samples
+    size_t indexes;
+    // Frame snapshot, drawing commands, screen and density caches, nearest
+    // sample grids and derived curves evaluation. Plots only
+    size_t rendering;
+    // Curves descriptions, labels and registries
+    size_t other;
+};
+
+/**
+ * Runtime information about a curve
+ */
+struct CurveMetrics {
+    int curve;
+    size_t samples;
+    size_t memory_bytes;
+    uint64_t points_added;
+    uint64_t points_evicted;
+};
+
+/**
+ * Statistics over the y values of the samples stored in a curve
+ */
+struct CurveStatistics {
+    CurveStatistics();
+
+    size_t count;
+    double mean;
+    double rms;
+    // Population standard deviation
+    double stddev;
+    float min;
+    float max;
+};
+
+/**
+ * Runtime information about a plot
+ */
+struct PlotMetrics {
+    PlotMetrics();
+
+    // Points added per second since the previous call to getMetrics()
+    double points_per_second;
+    uint64_t points_added;
+    uint64_t points_evicted;
+    uint64_t frames;
+    std::vector<CurveMetrics> curves;
+    // Time spent waiting for a curve's lock when it was already taken, by
+    // producers and the renderer
+    DurationDistribution lock_wait;
+    // Time spent producing a frame: inside RTPlotCore::prepareFrame(), when
+    // the frame is built in advance, and RTPlotCore::drawPlot()
+    DurationDistribution draw_duration;
+};
+
+/**
+ * Runtime information about a window and its plots
+ */
+struct WindowMetrics {
+    WindowMetrics();
+
+    std::vector<PlotMetrics> plots;
+    uint64_t refreshes;
+    // Number of automatic refreshes that didn't complete within their period
+    uint64_t missed_deadlines;
+};
+
+/**
+ * The phases of RTPlotCore::drawPlot() measured by the frame profiler
+ */
+enum class FramePhase {
+    Prepare,
+    Snapshot,
+    LabelsToggle,
+    Labels,
+    Axes,
+    ScaleInit,
+    Curves,
+    Replay,
+    CursorText
+};
+
+constexpr size_t frame_phase_count = 9;
+
+/**
+ * Statistics over the last durations of a drawing phase
+ */
+struct PhaseTimings {
+    PhaseTimings();
+
+    double mean_ns;
+    uint64_t p99_ns;
+    size_t samples;
+};
+
+/**
+ * Per phase and per curve timings of RTPlotCore::drawPlot(). Only available
+ * if the library has been built with the ENABLE_FRAME_PROFILER option.
+ */
+struct FrameProfile {
+    FrameProfile();
+
+    bool enabled;
+    std::array<PhaseTimings, frame_phase_count> phases;
+    // Time spent drawing each curve, indexed by curve
+    std::map<int, PhaseTimings> curves;
+};
+
+std::ostream& operator<<(std::ostream& out, const DurationDistribution& dist);
+std::ostream& operator<<(std::ostream& out, const CurveStatistics& stats);
+std::ostream& operator<<(std::ostream& out, const MemoryUsage& usage);
+std::ostream& operator<<(std::ostream& out, const PlotMetrics& metrics);
+std::ostream& operator<<(std::ostream& out, const WindowMetrics& metrics);
+std::ostream& operator<<(std::ostream& out, const FrameProfile& profile);
+
+} // namespace rtp
@@ -0,0 +1,40 @@
+/*      File: quality.h
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#pragma once
+
+namespace rtp {
+
+/**
+ * Rendering quality levels, from the most to the least detailed. Each level
+ * also applies the degradations of the previous ones.
+ */
+enum class QualityLevel {
+    // Everything is drawn
+    Full,
+    // At most one point per pixel is drawn, as with fast plotting
+    Decimated,
+    // The grid is not drawn and the refresh rate is halved
+    Reduced,
+    // At most one point every two pixels is drawn, the curves' labels are not
+    // drawn and the refresh rate is divided by four
+    Minimal
+};
+
+} // namespace rtp
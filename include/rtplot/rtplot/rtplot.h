@@ -20,10 +20,17 @@
 #pragma once
 
 #include "colors.h"
+#include "curve_handle.h"
+#include "export_format.h"
+#include "ingestion_filter.h"
+#include "metrics.h"
+#include "quality.h"
+#include "trigger_mode.h"
 
 #include <string>
 #include <memory>
 #include <vector>
+#include <iosfwd>
 
 namespace rtp {
 
@@ -33,6 +40,10 @@ class RTPlotCore;
  * GUI framework agnostic interface for real time data plotting.
  * RTPlot can handle multiple plots inside the same window, each containing
  * multiple curves, in real time with minimum CPU and memory usage.
+ *
+ * All the functions can be called from any thread. Producers adding points to
+ * different curves, in the same plot or not, run in parallel without sharing
+ * a lock once the plots and curves exist. See RTPlotCore for the details.
  */
 class RTPlot {
 public:
@@ -40,7 +51,10 @@ public:
     ~RTPlot();
 
     /**
-     * Set the size of the grig containing the plots.
+     * Set the size of the grig containing the plots. Can be called while
+     * producers add points. The plots falling outside of the new grid are
+     * not displayed anymore, but the CurveHandles obtained from them stay
+     * valid.
      * @param rows number of rows.
      * @param cols number of columns.
      */
@@ -56,6 +70,18 @@ public:
      */
     void addPoint(size_t plot, int curve, float x, float y);
 
+    /**
+     * Add several points to a curve at once.
+     * @param plot  the index of the plot containing the curve. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @param xs    the x coordinates of the points.
+     * @param ys    the y coordinates of the points.
+     * @param count the number of points.
+     */
+    void addPoints(size_t plot, int curve, const float* xs, const float* ys,
+                   size_t count);
+
     /**
      * Remove the first point of a curve.
      * @param plot  the index of the plot containing the curve. Must be in the
@@ -65,6 +91,194 @@ public:
      */
     void removeFirstPoint(size_t plot, int curve);
 
+    /**
+     * Get a handle giving direct access to a curve, to be used instead of
+     * addPoint() when adding points at a high rate. The handle stays valid
+     * until the plot is destroyed (RTPlot destruction or grid size
+     * reduction).
+     * @param plot  the index of the plot containing the curve. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @return the handle to the curve
+     */
+    CurveHandle getCurveHandle(size_t plot, int curve);
+
+    /**
+     * Add a new sample to a uniformly sampled curve (see
+     * setUniformSampling()).
+     * @param plot  the index of the plot containing the curve. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @param y     the y coordinate of the sample.
+     */
+    void addSample(size_t plot, int curve, float y);
+
+    /**
+     * Add several samples to a uniformly sampled curve at once.
+     * @param plot  the index of the plot containing the curve. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @param ys    the y coordinates of the samples.
+     * @param count the number of samples.
+     */
+    void addSamples(size_t plot, int curve, const float* ys, size_t count);
+
+    /**
+     * Add a sample to each of the curves [0, \a count[ of a plot, all sharing
+     * the same x coordinate. Faster than calling addPoint() for each curve,
+     * see RTPlotCore::addFrame().
+     * @param plot  the index of the plot containing the curves. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param x     the x coordinate of the frame.
+     * @param ys    the y coordinates of the curves' samples.
+     * @param count the number of values in ys.
+     */
+    void addFrame(size_t plot, float x, const float* ys, size_t count);
+
+    /**
+     * Display a curve of a plot in another one without duplicating its
+     * samples, e.g to have both an overview and a detailed view of a signal.
+     * See RTPlotCore::attachCurve().
+     * @param plot        the index of the plot to display the curve in. Must
+     * be in the [0, \a rows*\a cols[ interval.
+     * @param source_plot the index of the plot holding the curve. Must be in
+     * the [0, \a rows*\a cols[ interval.
+     * @param curve       the index of the curve. User defined, can be any
+     * number.
+     */
+    void attachCurve(size_t plot, size_t source_plot, int curve);
+
+    /**
+     * Make a curve uniformly sampled: only the y values are stored, the x
+     * coordinate of the i-th sample being x0 + i*dx. The points already
+     * present in the curve are removed.
+     * @param plot  the index of the plot containing the curve. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @param x0    the x coordinate of the first sample.
+     * @param dx    the x distance between two samples. Must be positive.
+     */
+    void setUniformSampling(size_t plot, int curve, float x0, float dx);
+
+    /**
+     * Filter the samples of a curve before storing them, see
+     * RTPlotCore::setIngestionFilter().
+     * @param plot   the index of the plot containing the curve. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param curve  the index of the curve. User defined, can be any number.
+     * @param filter the filter to apply.
+     * @param factor the number of samples per block.
+     */
+    void setIngestionFilter(size_t plot, int curve, IngestionFilter filter,
+                            size_t factor);
+
+    /**
+     * Set a trigger on a curve, see RTPlotCore::setTrigger().
+     * @param plot         the index of the plot containing the curve. Must be
+     * in the [0, \a rows*\a cols[ interval.
+     * @param curve        the index of the curve. User defined, can be any
+     * number.
+     * @param mode         the trigger condition.
+     * @param level        the y value the condition is evaluated against.
+     * @param pre_samples  the number of samples captured before the trigger.
+     * @param post_samples the number of samples captured after the trigger.
+     * @param sweeps       the number of captures displayed.
+     */
+    void setTrigger(size_t plot, int curve, TriggerMode mode, float level,
+                    size_t pre_samples, size_t post_samples,
+                    size_t sweeps = 1);
+
+    /**
+     * Remove the trigger of a curve, see RTPlotCore::removeTrigger().
+     * @param plot  the index of the plot containing the curve. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param curve the index of the curve. User defined, can be any number.
+     */
+    void removeTrigger(size_t plot, int curve);
+
+    /**
+     * Compute a curve as the difference between two others, see
+     * RTPlotCore::setDifferenceCurve().
+     * @param plot  the index of the plot containing the curves. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @param lhs   the index of the first source.
+     * @param rhs   the index of the second source.
+     */
+    void setDifferenceCurve(size_t plot, int curve, int lhs, int rhs);
+
+    /**
+     * Compute a curve as a scaled source, see RTPlotCore::setScaledCurve().
+     * @param plot   the index of the plot containing the curves. Must be in
+     * the [0, \a rows*\a cols[ interval.
+     * @param curve  the index of the curve. User defined, can be any number.
+     * @param source the index of the source.
+     * @param gain   the gain applied to the source's y values.
+     * @param offset the offset added to the source's y values.
+     */
+    void setScaledCurve(size_t plot, int curve, int source, float gain,
+                        float offset = 0.f);
+
+    /**
+     * Compute a curve as the moving average of a source, see
+     * RTPlotCore::setMovingAverageCurve().
+     * @param plot   the index of the plot containing the curves. Must be in
+     * the [0, \a rows*\a cols[ interval.
+     * @param curve  the index of the curve. User defined, can be any number.
+     * @param source the index of the source.
+     * @param window the number of samples averaged.
+     */
+    void setMovingAverageCurve(size_t plot, int curve, int source,
+                               size_t window);
+
+    /**
+     * Compute a curve as the amplitude spectrum of a source, see
+     * RTPlotCore::setSpectrumCurve().
+     * @param plot    the index of the plot containing the curves. Must be in
+     * the [0, \a rows*\a cols[ interval.
+     * @param curve   the index of the curve. User defined, can be any number.
+     * @param source  the index of the source.
+     * @param samples the number of samples transformed.
+     */
+    void setSpectrumCurve(size_t plot, int curve, int source, size_t samples);
+
+    /**
+     * Stop computing a derived curve, see RTPlotCore::removeDerivedCurve().
+     * @param plot  the index of the plot containing the curve. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param curve the index of the curve.
+     */
+    void removeDerivedCurve(size_t plot, int curve);
+
+    /**
+     * Enable the compression of the older samples of a curve, see
+     * RTPlotCore::enableCompression().
+     * @param plot        the index of the plot containing the curve. Must be
+     * in the [0, \a rows*\a cols[ interval.
+     * @param curve       the index of the curve. User defined, can be any
+     * number.
+     * @param raw_samples number of recent samples to keep uncompressed. Must
+     * be positive.
+     */
+    void enableCompression(size_t plot, int curve, size_t raw_samples);
+
+    /**
+     * Disable the compression of the new samples of a curve.
+     * @param plot  the index of the plot containing the curve. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param curve the index of the curve. User defined, can be any number.
+     */
+    void disableCompression(size_t plot, int curve);
+
+    /**
+     * Preallocate the storage of a curve, see RTPlotCore::reserve().
+     * @param plot  the index of the plot containing the curve. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @param count the number of samples
+     */
+    void reserve(size_t plot, int curve, size_t count);
+
     /**
      * Stop the plotting and close the window.
      */
@@ -105,7 +319,10 @@ public:
     void setPlotName(size_t plot, const std::string& name);
 
     /**
-     * Refresh the plots with the current data.
+     * Refresh the plots with the current data. The window is only marked as
+     * needing a redraw, which is performed asynchronously by the rendering
+     * thread, so this call never blocks. Multiple refresh requests made before
+     * the redraw happens are merged together.
      */
     void refresh();
 
@@ -115,6 +332,13 @@ public:
      */
     void enableAutoRefresh(uint period_ms);
 
+    /**
+     * Limit the number of redraws per second (60 by default). Requests
+     * arriving faster are delayed and merged.
+     * @param fps the maximum frame rate. Zero removes the limit.
+     */
+    void setMaxFrameRate(size_t fps);
+
     /**
      * Disable the automatic refreshing of the plots.
      */
@@ -239,6 +463,165 @@ public:
      */
     void disableFastPlotting(size_t plot);
 
+    /**
+     * Maintain running statistics over the curves of a given plot. See
+     * RTPlotCore::enableStatistics().
+     * @param plot    the index of the plot. Must be in the [0, \a rows*\a
+     * cols[ interval.
+     * @param display if true, the statistics are also shown in the labels
+     * area.
+     */
+    void enableStatistics(size_t plot, bool display = false);
+
+    /**
+     * Stop maintaining the statistics of the curves of a given plot.
+     * @param plot the index of the plot. Must be in the [0, \a rows*\a
+     * cols[ interval.
+     */
+    void disableStatistics(size_t plot);
+
+    /**
+     * Read the statistics of a given curve. See
+     * RTPlotCore::getStatistics().
+     * @param plot  the index of the plot. Must be in the [0, \a rows*\a
+     * cols[ interval.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @return the curve's statistics
+     */
+    CurveStatistics getStatistics(size_t plot, int curve);
+
+    /**
+     * Draw the curves of a given plot as density images. See
+     * RTPlotCore::enableDensityPlotting().
+     * @param plot        the index of the plot. Must be in the [0, \a
+     * rows*\a cols[ interval.
+     * @param persistence the fraction of the accumulated intensity kept each
+     * time a new frame is drawn, in the [0,1] interval.
+     */
+    void enableDensityPlotting(size_t plot, float persistence = 1.f);
+
+    /**
+     * Draw the curves of a given plot with lines again (default).
+     * @param plot the index of the plot. Must be in the [0, \a rows*\a
+     * cols[ interval.
+     */
+    void disableDensityPlotting(size_t plot);
+
+    /**
+     * Freeze the display of a given plot while its curves keep receiving
+     * samples. See RTPlotCore::freeze().
+     * @param plot the index of the plot. Must be in the [0, \a rows*\a
+     * cols[ interval.
+     */
+    void freeze(size_t plot);
+
+    /**
+     * Display the live content of a given plot again. See
+     * RTPlotCore::resume().
+     * @param plot the index of the plot. Must be in the [0, \a rows*\a
+     * cols[ interval.
+     */
+    void resume(size_t plot);
+
+    /**
+     * Read the runtime metrics of a given plot. See RTPlotCore::getMetrics.
+     * @param plot the index of the plot. Must be in the [0, \a rows*\a cols[
+     * interval.
+     * @return the plot metrics
+     */
+    PlotMetrics getMetrics(size_t plot);
+
+    /**
+     * Read the runtime metrics of the window and all its plots
+     * @return the window metrics
+     */
+    WindowMetrics getMetrics();
+
+    /**
+     * Number of bytes allocated for a curve. See
+     * RTPlotCore::getMemoryUsage(int).
+     * @param plot  the index of the plot containing the curve. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param curve the index of the curve.
+     * @return the memory usage
+     */
+    MemoryUsage getMemoryUsage(size_t plot, int curve);
+
+    /**
+     * Number of bytes allocated by a plot. See RTPlotCore::getMemoryUsage().
+     * @param plot the index of the plot. Must be in the [0, \a rows*\a cols[
+     * interval.
+     * @return the memory usage
+     */
+    MemoryUsage getMemoryUsage(size_t plot);
+
+    /**
+     * Number of bytes allocated by all the plots of the window, the curves
+     * shared between plots being accounted for once
+     * @return the memory usage
+     */
+    MemoryUsage getMemoryUsage();
+
+    /**
+     * Limit the memory used by the plots of all the windows. See
+     * RTPlotCore::setMemoryBudget().
+     * @param bytes the budget in bytes, zero to disable it
+     */
+    static void setMemoryBudget(size_t bytes);
+
+    /**
+     * Write the runtime metrics of the window and all its plots in a human
+     * readable form
+     * @param out the stream to write to
+     */
+    void dumpMetrics(std::ostream& out);
+
+    /**
+     * Write the samples of all the curves of a plot to a stream, without
+     * blocking the producers while writing. See RTPlotCore::exportData().
+     * @param plot   the index of the plot to export. Must be in the
+     * [0, \a rows*\a cols[ interval.
+     * @param out    the stream to write to
+     * @param format the format to use
+     */
+    void exportData(size_t plot, std::ostream& out, ExportFormat format);
+
+    /**
+     * Read the per phase drawing timings of a given plot. See
+     * RTPlotCore::getFrameProfile.
+     * @param plot the index of the plot. Must be in the [0, \a rows*\a cols[
+     * interval.
+     * @return the plot's frame profile
+     */
+    FrameProfile getFrameProfile(size_t plot);
+
+    /**
+     * Set the time allowed for drawing the whole window. The budget is
+     * equally shared between the plots of the grid. See
+     * RTPlotCore::setFrameBudget.
+     * @param budget_ms the frame budget in milliseconds. Zero disables the
+     * quality adaptation.
+     */
+    void setFrameBudget(float budget_ms);
+
+    /**
+     * Set the time allowed for drawing a given plot. See
+     * RTPlotCore::setFrameBudget.
+     * @param plot the index of the plot. Must be in the [0, \a rows*\a cols[
+     * interval.
+     * @param budget_ms the frame budget in milliseconds. Zero disables the
+     * quality adaptation.
+     */
+    void setFrameBudget(size_t plot, float budget_ms);
+
+    /**
+     * Get the rendering quality currently used by a given plot
+     * @param plot the index of the plot. Must be in the [0, \a rows*\a cols[
+     * interval.
+     * @return the quality level
+     */
+    QualityLevel getQualityLevel(size_t plot);
+
 protected:
     /**
      * Must create and initialize the RTPlot window and layout.
@@ -252,7 +635,7 @@ protected:
     virtual std::shared_ptr<RTPlotCore> makePlot() = 0;
 
     /**
-     * Redraw the window when called
+     * Redraw the window when called. Called from the rendering thread only.
      */
     virtual void redraw() = 0;
 
@@ -282,16 +665,31 @@ protected:
 
 private:
     /**
-     * Check if the given plot exists. If not, create a new one.
+     * Check if the given plot exists. If not, create a new one. Existing
+     * plots are found without taking any lock.
      * @param plot the index of the plot containing the curve. Must be in the
      * [0, \a rows*\a cols[ interval.
+     * @return the plot
      */
-    void checkPlot(size_t plot);
+    RTPlotCore& checkPlot(size_t plot);
 
     /**
-     * Update the layout to display the already created plots
+     * Update the layout to display the already created plots. plots_lock_
+     * must be held by the caller.
      */
     void updateLayout();
+
+    /**
+     * Prepare the next frame of all the plots in parallel. See
+     * RTPlotCore::prepareFrame.
+     */
+    void preparePlots();
+
+    /**
+     * Slow down the refresh rate if a plot had to reduce its rendering
+     * quality to respect its frame budget
+     */
+    void adaptRefreshRate();
 };
 
 } // namespace rtp
@@ -20,19 +20,46 @@
 #pragma once
 
 #include "colors.h"
+#include "curve_handle.h"
+#include "export_format.h"
+#include "ingestion_filter.h"
+#include "metrics.h"
+#include "quality.h"
+#include "trigger_mode.h"
 
 #include <utility>
 #include <map>
-#include <deque>
 #include <vector>
 #include <mutex>
 #include <set>
 #include <limits>
+#include <chrono>
+#include <memory>
+#include <tuple>
+#include <atomic>
+#include <string>
 
 namespace rtp {
 
+struct CurveData;
+struct CurveSnapshot;
+struct FrameSeries;
+class DerivedCurve;
+class FrameProfiler;
+class PolylineClipper;
+class RenderCommandBuffer;
+
 /**
  * Common interface for all RTPlot implementations.
+ *
+ * Concurrency model: all the public functions can be called from any thread.
+ * Points can be added to different curves from different threads in parallel
+ * without contending on a shared lock: each curve has its own lock and state
+ * and the lookup of existing curves by index goes through one of several
+ * independent registries. Only the first access to a curve, which creates it,
+ * takes the plot wide lock, so curves should be created (e.g with
+ * getCurveHandle() or reserve()) before starting the producers. Adding points
+ * to the same curve from several threads is safe but serialized.
  */
 class RTPlotCore {
 public:
@@ -55,6 +82,16 @@ public:
      */
     void addPoint(int curve, float x, float y);
 
+    /**
+     * Add several points to a curve at once. Faster than calling addPoint()
+     * for each of them.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @param xs    the x coordinates of the points.
+     * @param ys    the y coordinates of the points.
+     * @param count the number of points.
+     */
+    void addPoints(int curve, const float* xs, const float* ys, size_t count);
+
     /**
      * Remove the first point of a curve.
      * @param curve the index of the curve. Must match with the index of a
@@ -62,6 +99,239 @@ public:
      */
     void removeFirstPoint(int curve);
 
+    /**
+     * Get a handle giving direct access to a curve, to be used instead of
+     * addPoint(int, float, float) when adding points at a high rate. The
+     * curve is created if it doesn't exist yet.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @return the handle to the curve
+     */
+    CurveHandle getCurveHandle(int curve);
+
+    /**
+     * Add a new sample to a uniformly sampled curve (see
+     * setUniformSampling()). Its x coordinate is deduced from its index.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @param y     the y coordinate of the sample.
+     */
+    void addSample(int curve, float y);
+
+    /**
+     * Add several samples to a uniformly sampled curve at once. Faster than
+     * calling addSample() for each of them.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @param ys    the y coordinates of the samples.
+     * @param count the number of samples.
+     */
+    void addSamples(int curve, const float* ys, size_t count);
+
+    /**
+     * Make a curve uniformly sampled: only the y values are stored, the x
+     * coordinate of the i-th sample being x0 + i*dx. This saves memory and
+     * makes the x range computation constant time. The points already
+     * present in the curve are removed.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @param x0    the x coordinate of the first sample.
+     * @param dx    the x distance between two samples. Must be positive.
+     */
+    void setUniformSampling(int curve, float x0, float dx);
+
+    /**
+     * Filter the samples of a curve before storing them, to reduce the memory
+     * and CPU usage of signals sampled much faster than what can be
+     * displayed. The filter processes the incoming samples by blocks of
+     * \a factor samples and stores one sample per block, or two with
+     * IngestionFilter::BlockMinMax. The x coordinates of uniformly sampled
+     * curves are adapted accordingly, which requires removing their stored
+     * samples. The curves of a frame series can't be filtered.
+     * @param curve  the index of the curve. User defined, can be any number.
+     * @param filter the filter to apply.
+     * @param factor the number of samples per block. A factor of one disables
+     * the filtering.
+     */
+    void setIngestionFilter(int curve, IngestionFilter filter, size_t factor);
+
+    /**
+     * Set a trigger on a curve, like on an oscilloscope. Each time the
+     * trigger condition is met by a stored sample, the \a pre_samples
+     * samples preceding it, the triggering one and the \a post_samples
+     * following ones are captured. The last \a sweeps captures are displayed
+     * instead of the curve, overlaid, their x coordinates being relative to
+     * the triggering sample. No trigger is detected while a capture is in
+     * progress. Replaces the curve's previous trigger, if any. The storage of
+     * the captures is allocated here so that they don't allocate on the
+     * producers' side (see reserve()).
+     * @param curve        the index of the curve. User defined, can be any
+     * number.
+     * @param mode         the trigger condition.
+     * @param level        the y value the condition is evaluated against.
+     * @param pre_samples  the number of samples captured before the trigger,
+     * fewer if the trigger happens sooner after setting it or clearing the
+     * curve.
+     * @param post_samples the number of samples captured after the trigger.
+     * @param sweeps       the number of captures displayed. Must be positive.
+     */
+    void setTrigger(int curve, TriggerMode mode, float level,
+                    size_t pre_samples, size_t post_samples,
+                    size_t sweeps = 1);
+
+    /**
+     * Remove the trigger of a curve and display its samples again
+     * @param curve the index of the curve. User defined, can be any number.
+     */
+    void removeTrigger(int curve);
+
+    /**
+     * Number of captures completed since the trigger of a curve has been set
+     * @param curve the index of the curve
+     * @return the number of captures, zero if the curve has no trigger
+     */
+    uint64_t getCaptureCount(int curve) const;
+
+    /**
+     * Compute a curve as the difference between two others, \a lhs - \a rhs,
+     * at the x coordinates of \a lhs. \a rhs is linearly interpolated. The x
+     * coordinates of both sources must be increasing.
+     *
+     * Derived curves are evaluated while drawing the plot, only if they are
+     * visible, and incrementally: the samples already computed are kept, like
+     * the ones of a regular curve, and only the ones added to the sources
+     * since the previous frame are processed. The samples already present in
+     * the curve are removed and no sample must be added to it directly.
+     * Derived curves can't be used as sources and the curves of a frame
+     * series can't be derived.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @param lhs   the index of the first source.
+     * @param rhs   the index of the second source.
+     */
+    void setDifferenceCurve(int curve, int lhs, int rhs);
+
+    /**
+     * Compute a curve as \a gain * y + \a offset for each sample of a source.
+     * See setDifferenceCurve() for the evaluation of derived curves.
+     * @param curve  the index of the curve. User defined, can be any number.
+     * @param source the index of the source.
+     * @param gain   the gain applied to the source's y values.
+     * @param offset the offset added to the source's y values.
+     */
+    void setScaledCurve(int curve, int source, float gain, float offset = 0.f);
+
+    /**
+     * Compute a curve as the mean of the last \a window samples of a source.
+     * See setDifferenceCurve() for the evaluation of derived curves.
+     * @param curve  the index of the curve. User defined, can be any number.
+     * @param source the index of the source.
+     * @param window the number of samples averaged. Must be positive.
+     */
+    void setMovingAverageCurve(int curve, int source, size_t window);
+
+    /**
+     * Compute a curve as the amplitude spectrum of the last \a samples
+     * samples of a source. The x coordinates are the frequencies, in cycles
+     * per unit of the source's x coordinates, the sampling period being the
+     * mean distance between the transformed samples. The spectrum is computed
+     * again each time the source changes, if the source holds enough samples.
+     * See setDifferenceCurve() for the evaluation of derived curves.
+     * @param curve   the index of the curve. User defined, can be any number.
+     * @param source  the index of the source.
+     * @param samples the number of samples transformed. Must be a power of two
+     * greater than one.
+     */
+    void setSpectrumCurve(int curve, int source, size_t samples);
+
+    /**
+     * Stop computing a derived curve. Its samples are kept and new ones can
+     * be added to it like to any other curve.
+     * @param curve the index of the curve.
+     */
+    void removeDerivedCurve(int curve);
+
+    /**
+     * Display a curve of another plot in this one. The samples are stored only
+     * once, for all the plots, and can be added through any of them. The
+     * label and the maximum number of points are shared too while the
+     * ranges, visibility and decimation stay specific to each plot. The curve
+     * keeps the same index and replaces the one already using it in this
+     * plot, if any. The curves of a frame series can't be shared.
+     * @param source the plot holding the curve. The curve is created if it
+     * doesn't exist yet.
+     * @param curve  the index of the curve. User defined, can be any number.
+     */
+    void attachCurve(RTPlotCore& source, int curve);
+
+    /**
+     * Add a frame to the plot's frame series: a sample for each of the curves
+     * [0, count[, all sharing the same x coordinate. The x coordinates are
+     * stored only once and the whole frame is added, or evicted (see
+     * setMaxPoints()), at once. The series is created by the first call, its
+     * curves being cleared, and the following frames must have the same
+     * number of values. The curves of the series can't receive points
+     * individually nor be compressed and removing the first point of one of
+     * them removes the first frame. Same real time guarantees as a
+     * CurveHandle once all the curves have been reserved (see reserve()).
+     * @param x     the x coordinate of the frame.
+     * @param ys    the y coordinates of the curves' samples.
+     * @param count the number of values in ys.
+     */
+    void addFrame(float x, const float* ys, size_t count);
+
+    /**
+     * Enable the compression of the older samples of a curve. Only the most
+     * recent samples are kept as is, the older ones being losslessly
+     * compressed in blocks. Compressed samples dense enough to not be
+     * distinguishable on screen are drawn without being decompressed.
+     * @param curve       the index of the curve. User defined, can be any
+     * number.
+     * @param raw_samples number of recent samples to keep uncompressed. Must
+     * be positive.
+     */
+    void enableCompression(int curve, size_t raw_samples);
+
+    /**
+     * Disable the compression of the new samples of a curve. The samples
+     * already compressed stay compressed.
+     * @param curve the index of the curve. User defined, can be any number.
+     */
+    void disableCompression(int curve);
+
+    /**
+     * Preallocate the storage of a curve for a given number of samples. As
+     * long as the curve holds at most this number of samples (see
+     * setMaxPoints()), adding and removing points through a CurveHandle
+     * never allocates memory or performs I/O, and so can be done from real
+     * time threads, even while the plot is frozen (see freeze()). The curve's
+     * lock inherits the priority of the producers waiting for it, so a lower
+     * priority renderer holding it is never starved by them. The reserved
+     * storage is never freed, even to enforce the memory budget (see
+     * setMemoryBudget()). Must be called after setUniformSampling() for
+     * uniformly sampled curves and is incompatible with compression.
+     * @param curve the index of the curve. User defined, can be any number.
+     * @param count the number of samples
+     */
+    void reserve(int curve, size_t count);
+
+    /**
+     * Write the samples of all the curves to a stream. The curves are
+     * captured at once, then written chunk by chunk straight from their
+     * storage, the compressed samples being decoded one block at a time. The
+     * producers are only blocked during the capture but the storage of the
+     * captured samples can't be reused (see reserve()) until the export ends.
+     *
+     * The binary format, in native byte order, is:
+     *  - "RTPLOT01" (8 bytes)
+     *  - 0x01020304 (uint32) to detect the byte order
+     *  - the number of curves (uint32)
+     *  - for each curve:
+     *    - its index (int32)
+     *    - its visibility (uint8)
+     *    - its label's length (uint32) and characters
+     *    - its number of samples N (uint64)
+     *    - the x coordinates (N float32), then the y ones (N float32)
+     * @param out    the stream to write to
+     * @param format the format to use
+     */
+    void exportData(std::ostream& out, ExportFormat format);
+
     /**
      * Display the curves' labels.
      */
@@ -125,11 +395,15 @@ public:
 
     /**
      * Enable the automatic computation of the display range for the x axis.
+     * The range is rounded so that the ticks fall on round values and is only
+     * updated when the data gets out of it or uses less than half of it.
      */
     void setAutoXRange();
 
     /**
      * Enable the automatic computation of the display range for the y axis.
+     * The range is rounded so that the ticks fall on round values and is only
+     * updated when the data gets out of it or uses less than half of it.
      */
     void setAutoYRange();
 
@@ -201,6 +475,206 @@ public:
      */
     void disableFastPlotting();
 
+    /**
+     * Maintain running statistics over the y values of the samples stored in
+     * each curve (off by default): their mean, RMS, standard deviation,
+     * minimum and maximum. They are updated as samples are added and removed,
+     * so reading them with getStatistics() takes constant time.
+     * @param display if true, the statistics of each curve are also shown
+     * below its label
+     */
+    void enableStatistics(bool display = false);
+
+    /**
+     * Stop maintaining the curves' statistics. See enableStatistics()
+     */
+    void disableStatistics();
+
+    /**
+     * Read the statistics of a given curve. See enableStatistics()
+     * @param curve the index of the curve. User defined, can be any number
+     * @return the statistics, with a null count if the curve is empty or the
+     * statistics are disabled
+     */
+    CurveStatistics getStatistics(int curve) const;
+
+    /**
+     * Find the sample of a curve closest to a position in the widget, e.g to
+     * identify the point under the cursor. For curves whose x coordinates are
+     * increasing, such as uniformly sampled ones, this is the sample with the
+     * closest x coordinate, found by a binary search, and distances are only
+     * measured along x. For the others it is the closest one on screen, found
+     * using a grid of the samples built on the first call and then updated
+     * with the samples added since the previous call. The grid is released if
+     * no lookup happens between two frames. Uses the ranges and the layout of
+     * the last drawn frame.
+     * @param curve        the index of the curve. User defined, can be any
+     * number
+     * @param position     the position in pixels
+     * @param point        the coordinates of the closest sample
+     * @param max_distance the samples further away, in pixels, are ignored
+     * @return false if no sample has been found or no frame has been drawn yet
+     */
+    bool findNearestPoint(
+        int curve, const PointXY& position, PointXY& point,
+        float max_distance = std::numeric_limits<float>::infinity());
+
+    /**
+     * Freeze the display on the curves' current content, e.g to inspect an
+     * anomaly, while samples are still added to the curves. The displayed
+     * samples are shared with the curves rather than copied, the ones
+     * removed in the meantime being kept alive until resume(). The frozen
+     * view can be zoomed and panned, with zoom() and pan() or with the mouse
+     * wheel and by dragging it with the left button. A middle click freezes
+     * or resumes the plot.
+     */
+    void freeze();
+
+    /**
+     * Display the curves' live content again and restore the ranges. See
+     * freeze()
+     */
+    void resume();
+
+    /**
+     * Tell if the plot is frozen. See freeze()
+     * @return true if frozen
+     */
+    bool isFrozen() const;
+
+    /**
+     * Zoom on a frozen plot. Does nothing if the plot isn't frozen
+     * @param factor the zoom factor, greater than one to zoom in
+     * @param center the position, in pixels, staying in place
+     */
+    void zoom(float factor, const PointXY& center);
+
+    /**
+     * Move the content of a frozen plot. Does nothing if the plot isn't
+     * frozen
+     * @param offset the displacement in pixels
+     */
+    void pan(const PointXY& offset);
+
+    /**
+     * Draw the curves as density images instead of lines (off by default).
+     * Each pixel of the plot area counts the samples falling into it and is
+     * shaded accordingly, which keeps dense or overlapping signals readable
+     * and makes the drawing time independent of the number of samples. The
+     * samples are accumulated as they arrive and stay displayed after their
+     * removal from the curve, until they fade out or the ranges or the plot
+     * size change, in which case only the stored samples are accumulated
+     * again. Requires a backend implementing drawImage(), the curves are
+     * drawn with lines otherwise.
+     * @param persistence the fraction of the accumulated intensity kept each
+     * time a new frame is drawn, in the [0,1] interval. 1 keeps the samples
+     * indefinitely.
+     */
+    void enableDensityPlotting(float persistence = 1.f);
+
+    /**
+     * Draw the curves with lines again. See enableDensityPlotting()
+     */
+    void disableDensityPlotting();
+
+    /**
+     * Read the runtime metrics of the plot. The points per second rate is
+     * computed over the time elapsed since the previous call.
+     * @return the current metrics
+     */
+    PlotMetrics getMetrics();
+
+    /**
+     * Reset all the counters and histograms returned by getMetrics()
+     */
+    void resetMetrics();
+
+    /**
+     * Number of bytes allocated for a curve: its samples, including the
+     * pooled storage, and everything maintained along them
+     * @param curve the index of the curve
+     * @return the memory usage
+     */
+    MemoryUsage getMemoryUsage(int curve);
+
+    /**
+     * Number of bytes allocated by the plot: its curves, including the ones
+     * shared with other plots, and its rendering state
+     * @return the memory usage
+     */
+    MemoryUsage getMemoryUsage();
+
+    /**
+     * Number of bytes allocated by several plots, the curves they share being
+     * accounted for once
+     * @param plots the plots
+     * @return the memory usage
+     */
+    static MemoryUsage getMemoryUsage(const std::vector<RTPlotCore*>& plots);
+
+    /**
+     * Number of bytes allocated by all the existing plots, the ones the
+     * memory budget applies to
+     * @return the memory usage
+     */
+    static MemoryUsage getGlobalMemoryUsage();
+
+    /**
+     * Limit the memory used by all the plots of the process. When
+     * getGlobalMemoryUsage() exceeds the budget, the oldest samples, across
+     * all the curves, are removed until it fits again, instead of letting the
+     * memory grow. The budget is checked when set and then by the renderers,
+     * at most every 100ms. The removal granularity is about 512 samples per
+     * curve. Evicting samples doesn't reduce the rendering state or the
+     * per curve bookkeeping, so a budget below them empties all the curves.
+     * The samples still displayed by a frozen plot are not evicted since
+     * their storage can't be freed until it is resumed. Neither are the ones
+     * of the curves not exceeding their reserved storage (see reserve()),
+     * which is kept so that their producers still don't allocate.
+     * @param bytes the budget in bytes, zero to disable it (the default)
+     */
+    static void setMemoryBudget(size_t bytes);
+
+    /**
+     * The current memory budget, see setMemoryBudget()
+     * @return the budget in bytes, zero if disabled
+     */
+    static size_t getMemoryBudget();
+
+    /**
+     * Read the per phase timings of drawPlot(). The returned profile is
+     * disabled unless the library has been built with the
+     * ENABLE_FRAME_PROFILER option.
+     * @return the timings over the last frames
+     */
+    FrameProfile getFrameProfile() const;
+
+    /**
+     * Set the time allowed for drawing the plot. When the drawing time goes
+     * above the budget, the rendering quality is progressively reduced (see
+     * QualityLevel) and restored once the drawing time is back well under the
+     * budget.
+     * @param budget_ms the frame budget in milliseconds. Zero disables the
+     * adaptation and restores the full quality.
+     */
+    void setFrameBudget(float budget_ms);
+
+    /**
+     * Get the rendering quality currently in use
+     * @return the quality level
+     */
+    QualityLevel getQualityLevel() const;
+
+    /**
+     * Perform the CPU side work of the next frame (data snapshot, decimation,
+     * coordinates transformation and ticks layout) so that the next call to
+     * drawPlot() only has to submit the result to the GUI toolkit. Can be
+     * called from any thread, as long as measureText() can. The widget's size
+     * and position are the ones read by the last drawPlot() call, on the GUI
+     * thread, nothing being prepared before the first one.
+     */
+    void prepareFrame();
+
 protected:
     enum class LineStyle { Solid, Dotted };
     enum class MouseEvent {
@@ -210,6 +684,10 @@ protected:
         LeftClick,
         MiddleClick,
         RightClick,
+        LeftButtonPressed,
+        LeftButtonReleased,
+        WheelUp,
+        WheelDown,
         Unknown
     };
 
@@ -282,6 +760,21 @@ protected:
     virtual void drawText(const std::string& text, const PointXY& position,
                           int angle = 0) = 0;
 
+    /**
+     * Draw an image using the current color, the intensity of each pixel
+     * giving the opacity of the color. Only used when density plotting is
+     * enabled, see enableDensityPlotting(). The default implementation
+     * doesn't draw anything and returns false.
+     * @param position    the coordinates of the top-left corner of the image
+     * @param width       the width of the image in pixels
+     * @param height      the height of the image in pixels
+     * @param intensities the width * height pixels intensities, row by row
+     * @return true if the image has been drawn, false if images are not
+     * supported by the backend
+     */
+    virtual bool drawImage(const PointXY& position, size_t width,
+                           size_t height, const uint8_t* intensities);
+
     /**
      * Measure the size of a text
      * @param  text the text to measure
@@ -347,11 +840,72 @@ private:
      */
     virtual void drawAxes() final;
 
+    /**
+     * Draw the visible curves
+     */
+    virtual void drawCurves() final;
+
+    /**
+     * Draw the captured sweeps of a triggered curve, relative to their
+     * trigger, with the current color
+     * @param data             the curve's snapshot
+     * @param clipper          the clipper used to draw the curves
+     * @param pixels_per_point the minimal distance between drawn points
+     */
+    void drawSweeps(const CurveSnapshot& data, PolylineClipper& clipper,
+                    float pixels_per_point);
+
+    /**
+     * Draw the visible curves as density images
+     */
+    virtual void drawDensity() final;
+
     /**
      * Draw the curves labels
      */
     virtual void drawLabels() final;
 
+    /**
+     * Compute the width of the labels area from the curves' labels
+     */
+    void updateLabelAreaWidth();
+
+    /**
+     * Height of each curve's entry in the labels area
+     * @return the height in pixels
+     */
+    int labelRowHeight() const;
+
+    /**
+     * Find the sample of a curve closest to a position. See
+     * findNearestPoint(). frame_lock_ must be held
+     * @param data         the curve
+     * @param position     the position in pixels
+     * @param max_distance the samples further away, in pixels, are ignored
+     * @param point        the coordinates of the closest sample
+     * @return false if no sample has been found or no frame has been drawn yet
+     */
+    bool findNearestSample(CurveData& data, const PointXY& position,
+                           float max_distance, PointXY& point);
+
+    /**
+     * Find the sample of a snapshot closest to a position. See
+     * findNearestPoint(). frame_lock_ must be held
+     * @param data         the snapshot, e.g a frozen curve's pinned one
+     * @param position     the position in pixels
+     * @param max_distance the samples further away, in pixels, are ignored
+     * @param point        the coordinates of the closest sample
+     * @return false if no sample has been found or no frame has been drawn yet
+     */
+    bool findNearestSample(const CurveSnapshot& data, const PointXY& position,
+                           float max_distance, PointXY& point);
+
+    /**
+     * Draw the coordinates of the sample of each visible curve closest to the
+     * cursor, or the ones of the cursor if no sample is close enough
+     */
+    void drawCursorReadout();
+
     /**
      * Initialize the scaleToPlot method. For performance reason only.
      */
@@ -373,45 +927,291 @@ private:
 
     /**
      * Draw the value associated to a x axis tick.
-     * @param num   the value to draw
+     * @param value the formatted value to draw
      * @param point the text position
      */
-    virtual void drawXTickValue(float num, const PointXY& point) final;
+    virtual void drawXTickValue(const std::string& value,
+                                const PointXY& point) final;
 
     /**
      * Draw the value associated to a y axis tick.
-     * @param num   the value to draw
+     * @param value the formatted value to draw
      * @param point the text position
      */
-    virtual void drawYTickValue(float num, const PointXY& point) final;
+    virtual void drawYTickValue(const std::string& value,
+                                const PointXY& point) final;
 
     void handleLeftClick(PointXY cursor_position);
 
-    struct CurveData {
-        CurveData()
-            : previous_insertion_point(std::make_pair(
-                  ordered_list.first.end(), ordered_list.second.end())),
-              max_points(std::numeric_limits<size_t>::max()),
-              is_visible(true) {
-        }
-
-        std::deque<PointXY> points;
-        std::pair<std::multiset<float>, std::multiset<float>> ordered_list;
-        std::pair<std::multiset<float>::const_iterator,
-                  std::multiset<float>::const_iterator>
-            previous_insertion_point;
-        std::string label;
-        size_t max_points;
-        bool is_visible;
-        std::mutex lock_;
+    /**
+     * Tell if a position is inside the plot area
+     * @param position the position in pixels
+     * @return true if inside
+     */
+    bool insidePlot(const PointXY& position) const;
+
+    /**
+     * Adapt the rendering quality to the frame budget
+     * @param draw_time_ms the duration of the last frame, prepareFrame() and
+     * drawPlot() calls included
+     */
+    void updateQuality(float draw_time_ms);
+
+    /**
+     * Grab a consistent view of all the curves to be drawn during the current
+     * frame. The locks are only held while copying the segments' pointers so
+     * the drawing itself never blocks the producers.
+     */
+    void takeSnapshot();
+
+    /**
+     * Evaluate the visible derived curves from the current content of their
+     * sources. curves_lock_ must be held
+     */
+    void updateDerivedCurves();
+
+    /**
+     * Replace the definition of a derived curve, see setDifferenceCurve()
+     * @param curve   the index of the curve
+     * @param derived the new definition
+     */
+    void setDerivedCurve(int curve, std::unique_ptr<DerivedCurve> derived);
+
+    /**
+     * Add the memory used by the plot to a total
+     * @param usage   the total to update
+     * @param counted the curves already accounted for, updated with the ones
+     * of the plot
+     */
+    void accountMemory(MemoryUsage& usage,
+                       std::set<const CurveData*>& counted);
+
+    /**
+     * Remove the oldest samples of all the plots until they fit in the memory
+     * budget
+     * @param force check the budget even if it has been checked less than
+     * 100ms ago, waiting for another thread checking it
+     */
+    static void enforceMemoryBudget(bool force);
+
+    /**
+     * Remove the oldest samples of a curve, the ones stored at about the same
+     * time, and free the pooled storage not reserved by reserve(). The whole
+     * frames are removed for the curves of a frame series. Nothing is removed
+     * if the samples are still referenced by a snapshot or if the curve
+     * doesn't exceed its reserved storage. The curve's lock must be held
+     * @param data the curve, not empty
+     * @return the number of bytes freed, zero if nothing could be freed
+     */
+    size_t evictOldestSamples(CurveData& data);
+
+    /**
+     * Update the visibility of the pinned curves and apply the zoom and pan
+     * of a frozen plot, instead of taking a new snapshot
+     */
+    void refreshFrozenSnapshot();
+
+    // Size and position of the widget, in pixels
+    struct WidgetGeometry {
+        size_t width;
+        size_t height;
+        int x;
+        int y;
     };
-    std::map<int, CurveData> curves_data_;
+
+    /**
+     * Read the widget's size and position. Must be called from the GUI
+     * thread
+     * @return the geometry
+     */
+    WidgetGeometry readWidgetGeometry();
+
+    /**
+     * Compute the plot area position and size from the widget's ones
+     * @param widget the widget's geometry
+     * @return true if the plot area changed, false otherwise
+     */
+    bool computeLayout(const WidgetGeometry& widget);
+
+    /**
+     * Do the CPU side work of a frame. frame_lock_ must be held by the caller.
+     */
+    void buildFrame();
+
+    /**
+     * Format the values associated to the major ticks
+     */
+    void computeTicks();
+
+    /**
+     * Execute the drawing commands recorded in a buffer using the backend's
+     * drawing functions
+     * @param buffer the commands to execute
+     */
+    void replay(const RenderCommandBuffer& buffer);
+
+    /**
+     * Mark the current frame as outdated so that it gets recorded again
+     */
+    void invalidate();
+
+    /**
+     * Mark the current frame as outdated after a change of the curves'
+     * content, unless the plot is frozen
+     */
+    void invalidateData();
+
+    /**
+     * Remove the first point of a curve. The curve's lock must be held by the
+     * caller.
+     * @param data the curve to remove the point from
+     */
+    void popFront(CurveData& data);
+
+    /**
+     * Mark the frames of all the plots displaying a curve as outdated. The
+     * curve's lock must be held by the caller.
+     * @param data the modified curve
+     */
+    void invalidatePlots(const CurveData& data);
+
+    /**
+     * Position of a curve in the registry, or of its insertion point if it
+     * doesn't exist. curves_lock_ must be held by the caller.
+     * @param curve the index of the curve
+     * @return the position in curves_
+     */
+    size_t curvePosition(int curve) const;
+
+    /**
+     * Add a curve to the registry and to its shard, replacing the one with
+     * the same index if any. curves_lock_ must be held by the caller.
+     * @param data the curve to add
+     */
+    void registerCurve(std::shared_ptr<CurveData> data);
+
+    /**
+     * Find a curve in the registry. curves_lock_ must be held by the caller.
+     * @param curve the index of the curve
+     * @return the curve's data or nullptr if it doesn't exist
+     */
+    CurveData* findCurve(int curve) const;
+
+    /**
+     * Get a curve from the registry, creating it if needed. curves_lock_ must
+     * be held by the caller.
+     * @param curve the index of the curve
+     * @return the curve's data
+     */
+    CurveData& getCurve(int curve);
+
+    /**
+     * Find a curve using its shard only, without taking curves_lock_
+     * @param curve the index of the curve
+     * @return the curve's data or nullptr if it doesn't exist
+     */
+    CurveData* lookupCurve(int curve) const;
+
+    /**
+     * Same as getCurve() but only takes curves_lock_ if the curve has to be
+     * created
+     * @param curve the index of the curve
+     * @return the curve's data
+     */
+    CurveData& getCurveConcurrently(int curve);
+
+    friend class CurveHandle;
+
+    /**
+     * Get the plot's frame series, creating it if needed. curves_lock_ must be
+     * held by the caller.
+     * @param channels the number of curves in the series, used on creation
+     * @return the series
+     */
+    FrameSeries& getFrameSeries(size_t channels);
+
+    /**
+     * Remove the first frame of a series. The series' lock must be held by
+     * the caller.
+     * @param series the series to remove the frame from
+     */
+    void popFrontFrame(FrameSeries& series);
+
+    // Return false if the number of values doesn't match the series' one
+    bool addFrame(FrameSeries& series, float x, const float* ys, size_t count);
+
+    // Used by the CurveHandles, never allocate or print once the curve's
+    // storage has been reserved, the curve's lock boosting its holder if
+    // needed. Return false if the curve's type doesn't match
+    bool addPoint(CurveData& data, float x, float y);
+    bool addPoints(CurveData& data, const float* xs, const float* ys,
+                   size_t count);
+    bool addSample(CurveData& data, float y);
+    bool addSamples(CurveData& data, const float* ys, size_t count);
+    void removeFirstPoint(CurveData& data);
+
+    // Store a filtered sample. The curve's lock must be held by the caller
+    void storePoint(CurveData& data, float x, float y);
+    void storeSample(CurveData& data, float y);
+
+    // Registry of the curves, sorted by index. The curves can be shared with
+    // other plots (see attachCurve())
+    std::vector<std::shared_ptr<CurveData>> curves_;
+    // Curves replaced in curves_, kept alive so that their CurveHandles stay
+    // valid
+    std::vector<std::shared_ptr<CurveData>> detached_curves_;
+    // Indexes of the curves not drawn by this plot
+    std::set<int> hidden_curves_;
+    // Protects the curves_ structure, the curves visibility and the automatic
+    // ranges
+    mutable std::mutex curves_lock_;
+
+    // Number of independent curve registries used by the producers
+    static constexpr size_t curve_shards = 16;
+
+    // Subset of the registry holding the curves whose index modulo
+    // curve_shards is the shard's index, sorted by index
+    struct CurveShard;
+
+    CurveShard& shardOf(int curve) const;
+
+    std::unique_ptr<CurveShard[]> shards_;
+
+    // Created by the first call to addFrame(), never destroyed after
+    std::unique_ptr<FrameSeries> frame_series_;
+    // Same as frame_series_, read by the producers without holding
+    // curves_lock_
+    std::atomic<FrameSeries*> frame_series_ptr_;
+
+    // Frame snapshot, drawing commands and caches, see rtplot_core.cpp
+    struct RenderState;
+    std::unique_ptr<RenderState> render_;
+    // Curves computed from other ones, by index. Protected by curves_lock_
+    std::map<int, std::unique_ptr<DerivedCurve>> derived_curves_;
+    // New samples of the derived curve being evaluated
+    std::vector<PointXY> derived_samples_;
+    std::vector<std::string> xtick_values_;
+    std::vector<std::string> ytick_values_;
+    // Protects the frame data between prepareFrame() and drawPlot()
+    std::mutex frame_lock_;
+    // Decoded content of the compressed blocks being drawn
+    std::vector<PointXY> decoded_points_;
+    std::vector<float> decoded_values_;
+    // Set each time something affecting the rendering changes, cleared when
+    // the drawing commands are recorded
+    std::atomic<bool> frame_outdated_;
     Pairf xrange_;
     Pairf yrange_;
     Pairf xrange_auto_;
     Pairf yrange_auto_;
+    // Rounded automatic ranges, kept while they fit the data
+    Pairf nice_xrange_;
+    Pairf nice_yrange_;
     std::pair<int, int> xbounds_;
     std::pair<int, int> ybounds_;
+    // Read by drawPlot() since the GUI toolkits' getters can't be called from
+    // prepareFrame()
+    WidgetGeometry widget_;
     PointXY plot_offset_;
     Pairf plot_size_;
     int label_area_width_;
@@ -420,18 +1220,57 @@ private:
     std::string ylabel_;
     std::string plot_name_;
     std::pair<size_t, size_t> last_cursor_position_;
-    bool auto_xrange_;
-    bool auto_yrange_;
+    // Read by the producers without holding curves_lock_
+    std::atomic<bool> auto_xrange_;
+    std::atomic<bool> auto_yrange_;
     bool display_labels_;
     bool toggle_labels_;
     bool display_cursor_coordinates_;
     bool fast_plotting_;
+    // Protected by curves_lock_
+    bool statistics_;
+    std::atomic<bool> display_statistics_;
+    // Set when the labels area must be resized on the next draw
+    std::atomic<bool> label_area_outdated_;
 
     Pairf current_xrange_, current_yrange_;
     float current_xscale_, current_yscale_;
+    // Ranges and layout the screen caches are valid for
+    std::tuple<Pairf, Pairf, PointXY, Pairf> screen_transform_;
+
+    // While frozen, the frame snapshot is kept between the frames and the
+    // ranges come from the view ones, changed by zoom() and pan(). Protected
+    // by frame_lock_, frozen_ is also read by the producers
+    std::atomic<bool> frozen_;
+    Pairf view_xrange_;
+    Pairf view_yrange_;
+    // Set while the frozen view is dragged with the left button
+    bool dragging_;
+
+    std::atomic<bool> density_plotting_;
+    std::atomic<float> persistence_;
+    // Set when the backend fails to draw an image
+    std::atomic<bool> images_unsupported_;
 
     std::string display_labels_btn_text_;
     std::vector<Colors> palette_;
+
+    DurationHistogram lock_wait_;
+    DurationHistogram draw_duration_;
+    // Time spent in prepareFrame() since the last drawPlot() call. Protected
+    // by frame_lock_
+    std::chrono::steady_clock::duration prepare_duration_;
+    std::atomic<uint64_t> frames_;
+    std::chrono::steady_clock::time_point last_metrics_poll_;
+    uint64_t last_metrics_points_;
+    // Only allocated when built with ENABLE_FRAME_PROFILER
+    std::unique_ptr<FrameProfiler> profiler_;
+
+    std::atomic<float> frame_budget_ms_;
+    std::atomic<QualityLevel> quality_;
+    float average_draw_time_ms_;
+    size_t frames_since_quality_change_;
+    size_t frames_under_budget_;
 };
 
 } // namespace rtp
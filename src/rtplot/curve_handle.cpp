@@ -0,0 +1,67 @@
+/*      File: curve_handle.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/curve_handle.h>
+#include <rtplot/rtplot_core.h>
+#include <rtplot/internal/curve_data.h>
+
+#include <cassert>
+
+using namespace rtp;
+
+CurveHandle::CurveHandle() : plot_(nullptr), data_(nullptr) {
+}
+
+CurveHandle::CurveHandle(RTPlotCore* plot, CurveData* data)
+    : plot_(plot), data_(data) {
+}
+
+bool CurveHandle::addPoint(float x, float y) {
+    assert(isValid());
+    return plot_->addPoint(*data_, x, y);
+}
+
+bool CurveHandle::addPoints(const float* xs, const float* ys, size_t count) {
+    assert(isValid());
+    return plot_->addPoints(*data_, xs, ys, count);
+}
+
+bool CurveHandle::addSample(float y) {
+    assert(isValid());
+    return plot_->addSample(*data_, y);
+}
+
+bool CurveHandle::addSamples(const float* ys, size_t count) {
+    assert(isValid());
+    return plot_->addSamples(*data_, ys, count);
+}
+
+void CurveHandle::removeFirstPoint() {
+    assert(isValid());
+    plot_->removeFirstPoint(*data_);
+}
+
+int CurveHandle::getCurve() const {
+    assert(isValid());
+    return data_->id;
+}
+
+bool CurveHandle::isValid() const {
+    return plot_ != nullptr and data_ != nullptr;
+}
@@ -0,0 +1,311 @@
+/*      File: compressed_block.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/compressed_block.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+using namespace rtp;
+
+namespace {
+
+uint32_t toBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float fromBits(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+size_t countLeadingZeros(uint32_t value) {
+    size_t count = 0;
+    for (uint32_t mask = 0x80000000u; mask and not(value & mask); mask >>= 1) {
+        ++count;
+    }
+    return count;
+}
+
+size_t countTrailingZeros(uint32_t value) {
+    size_t count = 0;
+    for (uint32_t mask = 1u; mask and not(value & mask); mask <<= 1) {
+        ++count;
+    }
+    return count;
+}
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint64_t>& words)
+        : words_(words), used_(64) {
+        words_.clear();
+    }
+
+    // Write the nbits (at most 64) least significant bits of value
+    void write(uint64_t value, size_t nbits) {
+        while (nbits > 0) {
+            if (used_ == 64) {
+                words_.push_back(0);
+                used_ = 0;
+            }
+            size_t n = std::min(nbits, 64 - used_);
+            uint64_t chunk = value >> (nbits - n);
+            if (n < 64) {
+                chunk &= (uint64_t(1) << n) - 1;
+            }
+            words_.back() |= chunk << (64 - used_ - n);
+            used_ += n;
+            nbits -= n;
+        }
+    }
+
+private:
+    std::vector<uint64_t>& words_;
+    size_t used_;
+};
+
+class BitReader {
+public:
+    explicit BitReader(const std::vector<uint64_t>& words)
+        : words_(words), position_(0) {
+    }
+
+    uint64_t read(size_t nbits) {
+        uint64_t value = 0;
+        while (nbits > 0) {
+            size_t used = position_ % 64;
+            size_t n = std::min(nbits, 64 - used);
+            uint64_t chunk = words_[position_ / 64] >> (64 - used - n);
+            if (n < 64) {
+                chunk &= (uint64_t(1) << n) - 1;
+                value = (value << n) | chunk;
+            } else {
+                value = chunk;
+            }
+            position_ += n;
+            nbits -= n;
+        }
+        return value;
+    }
+
+private:
+    const std::vector<uint64_t>& words_;
+    size_t position_;
+};
+
+/**
+ * Gorilla's XOR encoding of float values
+ */
+class XorEncoder {
+public:
+    XorEncoder() : previous_(0), leading_(33), trailing_(0), first_(true) {
+    }
+
+    void encode(BitWriter& writer, float value) {
+        uint32_t bits = toBits(value);
+        if (first_) {
+            writer.write(bits, 32);
+            first_ = false;
+        } else {
+            uint32_t diff = bits ^ previous_;
+            if (diff == 0) {
+                writer.write(0, 1);
+            } else {
+                size_t leading = std::min<size_t>(countLeadingZeros(diff), 31);
+                size_t trailing = countTrailingZeros(diff);
+                if (leading >= leading_ and trailing >= trailing_) {
+                    // Fits in the previous meaningful bits window
+                    writer.write(0b10, 2);
+                    writer.write(diff >> trailing_, 32 - leading_ - trailing_);
+                } else {
+                    size_t length = 32 - leading - trailing;
+                    writer.write(0b11, 2);
+                    writer.write(leading, 5);
+                    writer.write(length - 1, 5);
+                    writer.write(diff >> trailing, length);
+                    leading_ = leading;
+                    trailing_ = trailing;
+                }
+            }
+        }
+        previous_ = bits;
+    }
+
+    float decode(BitReader& reader) {
+        if (first_) {
+            previous_ = uint32_t(reader.read(32));
+            first_ = false;
+        } else if (reader.read(1)) {
+            if (reader.read(1)) {
+                leading_ = reader.read(5);
+                size_t length = reader.read(5) + 1;
+                trailing_ = 32 - leading_ - length;
+            }
+            uint32_t diff = uint32_t(reader.read(32 - leading_ - trailing_))
+                            << trailing_;
+            previous_ ^= diff;
+        }
+        return fromBits(previous_);
+    }
+
+private:
+    uint32_t previous_;
+    size_t leading_;
+    size_t trailing_;
+    bool first_;
+};
+
+/**
+ * Delta-of-delta encoding of the binary representation of float values
+ */
+class DeltaOfDeltaEncoder {
+public:
+    DeltaOfDeltaEncoder() : previous_(0), delta_(0), first_(true) {
+    }
+
+    void encode(BitWriter& writer, float value) {
+        int64_t bits = toBits(value);
+        if (first_) {
+            writer.write(uint64_t(bits), 32);
+            first_ = false;
+        } else {
+            int64_t delta = bits - previous_;
+            int64_t dod = delta - delta_;
+            // zigzag encoding to map small negative values to small integers
+            auto zz = (uint64_t(dod) << 1) ^ uint64_t(dod >> 63);
+            if (zz == 0) {
+                writer.write(0, 1);
+            } else if (zz < (1u << 7)) {
+                writer.write(0b10, 2);
+                writer.write(zz, 7);
+            } else if (zz < (1u << 9)) {
+                writer.write(0b110, 3);
+                writer.write(zz, 9);
+            } else if (zz < (1u << 12)) {
+                writer.write(0b1110, 4);
+                writer.write(zz, 12);
+            } else {
+                writer.write(0b1111, 4);
+                writer.write(zz, 34);
+            }
+            delta_ = delta;
+        }
+        previous_ = bits;
+    }
+
+    float decode(BitReader& reader) {
+        if (first_) {
+            previous_ = int64_t(reader.read(32));
+            first_ = false;
+        } else {
+            size_t nbits = 0;
+            if (reader.read(1)) {
+                if (not reader.read(1)) {
+                    nbits = 7;
+                } else if (not reader.read(1)) {
+                    nbits = 9;
+                } else if (not reader.read(1)) {
+                    nbits = 12;
+                } else {
+                    nbits = 34;
+                }
+            }
+            uint64_t zz = nbits ? reader.read(nbits) : 0;
+            auto dod = int64_t(zz >> 1) ^ -int64_t(zz & 1);
+            delta_ += dod;
+            previous_ += delta_;
+        }
+        return fromBits(uint32_t(previous_));
+    }
+
+private:
+    int64_t previous_;
+    int64_t delta_;
+    bool first_;
+};
+
+} // namespace
+
+CompressedBlock::CompressedBlock(const std::vector<PointXY>& points)
+    : count_(points.size()), has_x_(true) {
+    encode(points.size(), [&points](size_t i) { return points[i]; });
+}
+
+CompressedBlock::CompressedBlock(const std::vector<float>& values)
+    : count_(values.size()), has_x_(false) {
+    encode(values.size(),
+           [&values](size_t i) { return PointXY(0.f, values[i]); });
+}
+
+template <typename Getter>
+void CompressedBlock::encode(size_t count, Getter get) {
+    xmin_ = ymin_ = std::numeric_limits<float>::infinity();
+    xmax_ = ymax_ = -std::numeric_limits<float>::infinity();
+
+    BitWriter writer(bits_);
+    DeltaOfDeltaEncoder x_encoder;
+    XorEncoder y_encoder;
+    for (size_t i = 0; i < count; ++i) {
+        auto point = get(i);
+        if (has_x_) {
+            x_encoder.encode(writer, point.first);
+            xmin_ = std::min(xmin_, point.first);
+            xmax_ = std::max(xmax_, point.first);
+        }
+        y_encoder.encode(writer, point.second);
+        ymin_ = std::min(ymin_, point.second);
+        ymax_ = std::max(ymax_, point.second);
+    }
+    bits_.shrink_to_fit();
+}
+
+void CompressedBlock::decode(std::vector<PointXY>& points) const {
+    assert(has_x_);
+    points.resize(count_);
+    BitReader reader(bits_);
+    DeltaOfDeltaEncoder x_decoder;
+    XorEncoder y_decoder;
+    for (auto& point : points) {
+        point.first = x_decoder.decode(reader);
+        point.second = y_decoder.decode(reader);
+    }
+}
+
+void CompressedBlock::decode(std::vector<float>& values) const {
+    values.resize(count_);
+    BitReader reader(bits_);
+    DeltaOfDeltaEncoder x_decoder;
+    XorEncoder y_decoder;
+    for (auto& value : values) {
+        if (has_x_) {
+            x_decoder.decode(reader);
+        }
+        value = y_decoder.decode(reader);
+    }
+}
+
+size_t CompressedBlock::memoryUsage() const {
+    return sizeof(CompressedBlock) + bits_.capacity() * sizeof(uint64_t);
+}
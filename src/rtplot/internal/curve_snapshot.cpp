@@ -0,0 +1,93 @@
+/*      File: curve_snapshot.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/curve_snapshot.h>
+
+#include <algorithm>
+
+using namespace rtp;
+
+namespace {
+
+// Maximum number of points given at once to the callback
+constexpr size_t chunk_size = 512;
+
+} // namespace
+
+void CurveSnapshot::read(
+    const std::function<void(const PointXY*, size_t)>& callback,
+    size_t first) const {
+    std::vector<PointXY> chunk;
+    chunk.reserve(chunk_size);
+    auto flush = [&chunk, &callback] {
+        if (not chunk.empty()) {
+            callback(chunk.data(), chunk.size());
+            chunk.clear();
+        }
+    };
+    auto sampleX = [this](size_t i) { return float(x0 + double(i) * dx); };
+
+    // Compressed samples, point blocks are given as decoded. The blocks
+    // entirely before the first sample are not decoded
+    size_t index = 0;
+    std::vector<PointXY> decoded_points;
+    std::vector<float> decoded_values;
+    for (size_t b = 0; b < cold_blocks.size(); ++b) {
+        size_t offset = b ? 0 : cold_offset;
+        size_t block_size = cold_blocks[b]->size() - offset;
+        if (index + block_size > first) {
+            size_t skip = first > index ? first - index : 0;
+            if (is_uniform) {
+                cold_blocks[b]->decode(decoded_values);
+                for (size_t i = skip; i < block_size; ++i) {
+                    chunk.emplace_back(sampleX(index + i),
+                                       decoded_values[offset + i]);
+                    if (chunk.size() == chunk_size) {
+                        flush();
+                    }
+                }
+            } else {
+                cold_blocks[b]->decode(decoded_points);
+                callback(decoded_points.data() + offset + skip,
+                         block_size - skip);
+            }
+        }
+        index += block_size;
+    }
+
+    // Raw samples
+    size_t raw_first = first > index ? first - index : 0;
+    if (is_uniform or is_series) {
+        for (size_t i = raw_first; i < values.size(); ++i) {
+            float x = is_series ? xs[i] : sampleX(index + i);
+            chunk.emplace_back(x, values[i]);
+            if (chunk.size() == chunk_size) {
+                flush();
+            }
+        }
+    } else {
+        for (size_t i = raw_first; i < points.size(); ++i) {
+            chunk.push_back(points[i]);
+            if (chunk.size() == chunk_size) {
+                flush();
+            }
+        }
+    }
+    flush();
+}
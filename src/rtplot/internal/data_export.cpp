@@ -0,0 +1,83 @@
+/*      File: data_export.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/data_export.h>
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+
+using namespace rtp;
+
+namespace {
+
+template <typename T> void writeValue(std::ostream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Write one coordinate of all the samples of a curve as a column of floats
+void writeColumn(std::ostream& out, const CurveSnapshot& curve,
+                 bool x_column) {
+    std::vector<float> column;
+    curve.read([&out, &column, x_column](const CurveSnapshot::PointXY* points,
+                                         size_t count) {
+        column.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            column[i] = x_column ? points[i].first : points[i].second;
+        }
+        out.write(reinterpret_cast<const char*>(column.data()),
+                  std::streamsize(count * sizeof(float)));
+    });
+}
+
+} // namespace
+
+void rtp::exportCsv(std::ostream& out,
+                    const std::vector<CurveSnapshot>& curves) {
+    auto precision = out.precision(std::numeric_limits<float>::max_digits10);
+    out << "curve,x,y\n";
+    for (const auto& curve : curves) {
+        curve.read([&out, &curve](const CurveSnapshot::PointXY* points,
+                                  size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                out << curve.curve << ',' << points[i].first << ','
+                    << points[i].second << '\n';
+            }
+        });
+    }
+    out.precision(precision);
+}
+
+void rtp::exportBinary(std::ostream& out,
+                       const std::vector<CurveSnapshot>& curves) {
+    const char magic[8] = {'R', 'T', 'P', 'L', 'O', 'T', '0', '1'};
+    out.write(magic, sizeof(magic));
+    // Written in the native byte order so that readers can detect it
+    writeValue<uint32_t>(out, 0x01020304);
+    writeValue<uint32_t>(out, uint32_t(curves.size()));
+    for (const auto& curve : curves) {
+        writeValue<int32_t>(out, curve.curve);
+        writeValue<uint8_t>(out, curve.is_visible);
+        writeValue<uint32_t>(out, uint32_t(curve.label.size()));
+        out.write(curve.label.data(), std::streamsize(curve.label.size()));
+        writeValue<uint64_t>(out, curve.size());
+        writeColumn(out, curve, true);
+        writeColumn(out, curve, false);
+    }
+}
@@ -0,0 +1,93 @@
+/*      File: density_histogram.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/density_histogram.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace rtp;
+
+namespace {
+
+// Decayed counts below this one are reset, which avoids computations on
+// denormal numbers
+constexpr float min_count = 1e-3f;
+
+} // namespace
+
+DensityHistogram::DensityHistogram() : width_(0), height_(0) {
+}
+
+void DensityHistogram::resize(size_t width, size_t height) {
+    width_ = width;
+    height_ = height;
+    counts_.assign(width * height, 0.f);
+}
+
+size_t DensityHistogram::width() const {
+    return width_;
+}
+
+size_t DensityHistogram::height() const {
+    return height_;
+}
+
+void DensityHistogram::clear() {
+    std::fill(counts_.begin(), counts_.end(), 0.f);
+}
+
+void DensityHistogram::decay(float factor) {
+    if (factor >= 1.f) {
+        return;
+    }
+    for (auto& count : counts_) {
+        count = count * factor >= min_count ? count * factor : 0.f;
+    }
+}
+
+void DensityHistogram::add(const PointXY& point) {
+    // Written so that NaNs are rejected too
+    if (not(point.first >= 0.f and point.first < float(width_) and
+            point.second >= 0.f and point.second < float(height_))) {
+        return;
+    }
+    counts_[size_t(point.second) * width_ + size_t(point.first)] += 1.f;
+}
+
+void DensityHistogram::render(uint8_t* intensities) const {
+    float max_count = 0.f;
+    for (auto count : counts_) {
+        max_count = std::max(max_count, count);
+    }
+    if (max_count <= 0.f) {
+        std::fill(intensities, intensities + counts_.size(), uint8_t(0));
+        return;
+    }
+    float scale = 255.f / std::log1p(max_count);
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        auto count = counts_[i];
+        intensities[i] =
+            count > 0.f ? uint8_t(std::log1p(count) * scale + 0.5f) : 0;
+    }
+}
+
+size_t DensityHistogram::memoryUsage() const {
+    return counts_.capacity() * sizeof(float);
+}
@@ -0,0 +1,294 @@
+/*      File: derived_curve.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/derived_curve.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace rtp;
+
+namespace {
+
+constexpr double pi = 3.14159265358979323846;
+
+} // namespace
+
+DerivedCurve::DerivedCurve(std::vector<int> sources)
+    : sources_(std::move(sources)),
+      cursors_(sources_.size()),
+      started_(false) {
+}
+
+bool DerivedCurve::update(const std::vector<CurveSnapshot>& sources,
+                          std::vector<PointXY>& output) {
+    assert(sources.size() == sources_.size());
+    bool restart = not started_;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const auto& cursor = cursors_[i];
+        restart = restart or cursor.generation != sources[i].generation or
+                  cursor.next < sources[i].first_sample;
+    }
+    if (restart) {
+        for (size_t i = 0; i < sources.size(); ++i) {
+            cursors_[i].generation = sources[i].generation;
+            cursors_[i].next = sources[i].first_sample;
+        }
+        started_ = true;
+        reset();
+    }
+    return evaluate(sources, output) or restart;
+}
+
+size_t DerivedCurve::memoryUsage() const {
+    return sources_.capacity() * sizeof(int) +
+           cursors_.capacity() * sizeof(Cursor);
+}
+
+size_t DerivedCurve::pending(size_t source,
+                             const CurveSnapshot& snapshot) const {
+    return size_t(snapshot.first_sample + snapshot.size() -
+                  cursors_[source].next);
+}
+
+void DerivedCurve::readPending(
+    size_t source, const CurveSnapshot& snapshot,
+    const std::function<void(const PointXY*, size_t)>& callback) {
+    if (pending(source, snapshot) > 0) {
+        snapshot.read(callback, size_t(cursors_[source].next -
+                                       snapshot.first_sample));
+        skipPending(source, snapshot);
+    }
+}
+
+void DerivedCurve::skipPending(size_t source, const CurveSnapshot& snapshot) {
+    cursors_[source].next = snapshot.first_sample + snapshot.size();
+}
+
+ScaledCurve::ScaledCurve(int source, float gain, float offset)
+    : DerivedCurve({source}), gain_(gain), offset_(offset) {
+}
+
+void ScaledCurve::reset() {
+}
+
+bool ScaledCurve::evaluate(const std::vector<CurveSnapshot>& sources,
+                           std::vector<PointXY>& output) {
+    readPending(0, sources[0], [this, &output](const PointXY* points,
+                                               size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            output.emplace_back(points[i].first,
+                                gain_ * points[i].second + offset_);
+        }
+    });
+    return false;
+}
+
+DifferenceCurve::DifferenceCurve(int lhs, int rhs) : DerivedCurve({lhs, rhs}) {
+}
+
+size_t DifferenceCurve::memoryUsage() const {
+    return DerivedCurve::memoryUsage() +
+           (lhs_.capacity() + rhs_.capacity()) * sizeof(PointXY);
+}
+
+void DifferenceCurve::reset() {
+    lhs_.clear();
+    rhs_.clear();
+}
+
+bool DifferenceCurve::evaluate(const std::vector<CurveSnapshot>& sources,
+                               std::vector<PointXY>& output) {
+    auto append = [](RingBuffer<PointXY>& buffer) {
+        return [&buffer](const PointXY* points, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                buffer.push_back(points[i]);
+            }
+        };
+    };
+    readPending(0, sources[0], append(lhs_));
+    readPending(1, sources[1], append(rhs_));
+
+    // The samples waiting for the second source are bounded by the ones
+    // stored in the sources
+    while (lhs_.size() > sources[0].size()) {
+        lhs_.pop_front();
+    }
+    while (rhs_.size() > sources[1].size() + 1) {
+        rhs_.pop_front();
+    }
+
+    while (not lhs_.empty() and not rhs_.empty()) {
+        const auto& point = lhs_.front();
+        // Nothing to compare with
+        if (point.first < rhs_.front().first) {
+            lhs_.pop_front();
+            continue;
+        }
+        while (rhs_.size() > 1 and rhs_[1].first <= point.first) {
+            rhs_.pop_front();
+        }
+        const auto& before = rhs_.front();
+        float y;
+        if (before.first == point.first) {
+            y = before.second;
+        } else if (rhs_.size() > 1) {
+            const auto& after = rhs_[1];
+            float t =
+                (point.first - before.first) / (after.first - before.first);
+            y = before.second + t * (after.second - before.second);
+        } else {
+            // The second source hasn't reached the sample yet
+            break;
+        }
+        output.emplace_back(point.first, point.second - y);
+        lhs_.pop_front();
+    }
+    return false;
+}
+
+MovingAverageCurve::MovingAverageCurve(int source, size_t window)
+    : DerivedCurve({source}), window_(window), sum_(0.), accumulated_(0) {
+    assert(window > 0);
+    values_.reserve(window);
+}
+
+size_t MovingAverageCurve::memoryUsage() const {
+    return DerivedCurve::memoryUsage() + values_.capacity() * sizeof(float);
+}
+
+void MovingAverageCurve::reset() {
+    values_.clear();
+    sum_ = 0.;
+    accumulated_ = 0;
+}
+
+bool MovingAverageCurve::evaluate(const std::vector<CurveSnapshot>& sources,
+                                  std::vector<PointXY>& output) {
+    readPending(0, sources[0], [this, &output](const PointXY* points,
+                                               size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (values_.size() == window_) {
+                sum_ -= values_.front();
+                values_.pop_front();
+            }
+            values_.push_back(points[i].second);
+            sum_ += points[i].second;
+            if (++accumulated_ == window_) {
+                sum_ = 0.;
+                for (size_t j = 0; j < values_.size(); ++j) {
+                    sum_ += values_[j];
+                }
+                accumulated_ = 0;
+            }
+            output.emplace_back(points[i].first,
+                                float(sum_ / double(values_.size())));
+        }
+    });
+    return false;
+}
+
+SpectrumCurve::SpectrumCurve(int source, size_t samples)
+    : DerivedCurve({source}), samples_(samples) {
+    assert(samples > 1 and (samples & (samples - 1)) == 0);
+    window_.reserve(samples);
+    spectrum_.resize(samples);
+    twiddles_.resize(samples / 2);
+    for (size_t k = 0; k < twiddles_.size(); ++k) {
+        double angle = -2. * pi * double(k) / double(samples);
+        twiddles_[k] = std::complex<float>(float(std::cos(angle)),
+                                           float(std::sin(angle)));
+    }
+}
+
+size_t SpectrumCurve::memoryUsage() const {
+    return DerivedCurve::memoryUsage() +
+           window_.capacity() * sizeof(PointXY) +
+           (spectrum_.capacity() + twiddles_.capacity()) *
+               sizeof(std::complex<float>);
+}
+
+void SpectrumCurve::reset() {
+}
+
+bool SpectrumCurve::evaluate(const std::vector<CurveSnapshot>& sources,
+                             std::vector<PointXY>& output) {
+    const auto& source = sources[0];
+    if (pending(0, source) == 0) {
+        return false;
+    }
+    skipPending(0, source);
+    if (source.size() < samples_) {
+        return false;
+    }
+
+    window_.clear();
+    source.read(
+        [this](const PointXY* points, size_t count) {
+            window_.insert(window_.end(), points, points + count);
+        },
+        source.size() - samples_);
+
+    float period = (window_.back().first - window_.front().first) /
+                   float(samples_ - 1);
+    if (not(period > 0.f)) {
+        period = 1.f;
+    }
+    for (size_t i = 0; i < samples_; ++i) {
+        spectrum_[i] = std::complex<float>(window_[i].second, 0.f);
+    }
+    transform();
+
+    // Single sided amplitudes, only the continuous and Nyquist components
+    // are not folded
+    float resolution = 1.f / (period * float(samples_));
+    for (size_t k = 0; k <= samples_ / 2; ++k) {
+        float scale = k == 0 or k == samples_ / 2 ? 1.f : 2.f;
+        output.emplace_back(float(k) * resolution,
+                            scale * std::abs(spectrum_[k]) / float(samples_));
+    }
+    return true;
+}
+
+void SpectrumCurve::transform() {
+    size_t n = samples_;
+    // Bit reversal permutation
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(spectrum_[i], spectrum_[j]);
+        }
+    }
+    for (size_t length = 2; length <= n; length <<= 1) {
+        size_t half = length / 2;
+        size_t step = n / length;
+        for (size_t i = 0; i < n; i += length) {
+            for (size_t k = 0; k < half; ++k) {
+                auto odd = spectrum_[i + k + half] * twiddles_[k * step];
+                spectrum_[i + k + half] = spectrum_[i + k] - odd;
+                spectrum_[i + k] += odd;
+            }
+        }
+    }
+}
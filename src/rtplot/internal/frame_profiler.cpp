@@ -0,0 +1,105 @@
+/*      File: frame_profiler.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/frame_profiler.h>
+
+#include <algorithm>
+
+using namespace rtp;
+
+RollingTimings::RollingTimings(size_t window)
+    : samples_(window, 0), next_(0), count_(0) {
+}
+
+void RollingTimings::record(std::chrono::nanoseconds duration) {
+    samples_[next_] = static_cast<uint64_t>(duration.count());
+    next_ = (next_ + 1) % samples_.size();
+    count_ = std::min(count_ + 1, samples_.size());
+}
+
+PhaseTimings RollingTimings::read() const {
+    PhaseTimings timings;
+    timings.samples = count_;
+    if (count_ == 0) {
+        return timings;
+    }
+
+    std::vector<uint64_t> sorted(samples_.begin(), samples_.begin() + count_);
+    uint64_t total = 0;
+    for (auto sample : sorted) {
+        total += sample;
+    }
+    timings.mean_ns = double(total) / double(count_);
+
+    auto p99 = sorted.begin() + (sorted.size() * 99) / 100;
+    std::nth_element(sorted.begin(), p99, sorted.end());
+    timings.p99_ns = *p99;
+    return timings;
+}
+
+void FrameProfiler::record(FramePhase phase,
+                           std::chrono::nanoseconds duration) {
+    std::lock_guard<std::mutex> lock(lock_);
+    phases_[static_cast<size_t>(phase)].record(duration);
+}
+
+void FrameProfiler::recordCurve(int curve, std::chrono::nanoseconds duration) {
+    std::lock_guard<std::mutex> lock(lock_);
+    curves_[curve].record(duration);
+}
+
+FrameProfile FrameProfiler::read() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    FrameProfile profile;
+    profile.enabled = true;
+    for (size_t i = 0; i < frame_phase_count; ++i) {
+        profile.phases[i] = phases_[i].read();
+    }
+    for (const auto& curve : curves_) {
+        profile.curves[curve.first] = curve.second.read();
+    }
+    return profile;
+}
+
+ScopedPhaseTimer::ScopedPhaseTimer(FrameProfiler* profiler, FramePhase phase)
+    : profiler_(profiler), phase_(phase) {
+    if (profiler_) {
+        start_ = std::chrono::steady_clock::now();
+    }
+}
+
+ScopedPhaseTimer::~ScopedPhaseTimer() {
+    if (profiler_) {
+        profiler_->record(phase_, std::chrono::steady_clock::now() - start_);
+    }
+}
+
+ScopedCurveTimer::ScopedCurveTimer(FrameProfiler* profiler, int curve)
+    : profiler_(profiler), curve_(curve) {
+    if (profiler_) {
+        start_ = std::chrono::steady_clock::now();
+    }
+}
+
+ScopedCurveTimer::~ScopedCurveTimer() {
+    if (profiler_) {
+        profiler_->recordCurve(curve_,
+                               std::chrono::steady_clock::now() - start_);
+    }
+}
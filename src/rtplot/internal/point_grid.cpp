@@ -0,0 +1,183 @@
+/*      File: point_grid.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/point_grid.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace rtp;
+
+namespace {
+
+// Bound of the cells' coordinates, far enough from the int32_t limits for
+// the ring computations to never overflow
+constexpr float max_cell = float(1 << 30);
+
+// Number of samples above which the grid is rebuilt, relative to the one it
+// has been built with
+constexpr size_t max_growth = 4;
+
+} // namespace
+
+PointGrid::PointGrid(const PointXY& cell_size, size_t samples)
+    : cell_size_(cell_size),
+      min_cell_(std::numeric_limits<int32_t>::max(),
+                std::numeric_limits<int32_t>::max()),
+      max_cell_(std::numeric_limits<int32_t>::min(),
+                std::numeric_limits<int32_t>::min()),
+      size_(0),
+      initial_samples_(samples) {
+}
+
+void PointGrid::insert(uint64_t sample, const PointXY& point) {
+    if (not std::isfinite(point.first) or not std::isfinite(point.second)) {
+        return;
+    }
+    auto cell = cellOf(point);
+    cells_[cell].push_back(Entry{sample, point});
+    min_cell_.first = std::min(min_cell_.first, cell.first);
+    min_cell_.second = std::min(min_cell_.second, cell.second);
+    max_cell_.first = std::max(max_cell_.first, cell.first);
+    max_cell_.second = std::max(max_cell_.second, cell.second);
+    ++size_;
+}
+
+bool PointGrid::nearest(const PointXY& position, const PointXY& scale,
+                        uint64_t first_sample, float max_distance,
+                        PointXY& nearest) const {
+    if (cells_.empty()) {
+        return false;
+    }
+
+    const float max_squared_distance = max_distance * max_distance;
+    float best = max_squared_distance;
+    bool found = false;
+    auto visitCell = [&](const std::vector<Entry>& entries) {
+        for (const auto& entry : entries) {
+            if (entry.sample < first_sample) {
+                continue;
+            }
+            float dx = (entry.point.first - position.first) * scale.first;
+            float dy = (entry.point.second - position.second) * scale.second;
+            float distance = dx * dx + dy * dy;
+            if (distance < best) {
+                best = distance;
+                nearest = entry.point;
+                found = true;
+            }
+        }
+    };
+    auto visit = [&](int64_t x, int64_t y) {
+        auto it = cells_.find(Cell(int32_t(x), int32_t(y)));
+        if (it != cells_.end()) {
+            visitCell(it->second);
+        }
+    };
+
+    // The cells are visited by rings of increasing size around the position.
+    // A sample in ring r is at least r - 1 cells away along one axis
+    auto center = cellOf(position);
+    int64_t cx = center.first;
+    int64_t cy = center.second;
+    int64_t min_x = min_cell_.first;
+    int64_t min_y = min_cell_.second;
+    int64_t max_x = max_cell_.first;
+    int64_t max_y = max_cell_.second;
+    int64_t first_ring =
+        std::max({int64_t(0), min_x - cx, cx - max_x, min_y - cy, cy - max_y});
+    int64_t last_ring =
+        std::max({cx - min_x, max_x - cx, cy - min_y, max_y - cy});
+    float step = std::min(std::abs(cell_size_.first * scale.first),
+                          std::abs(cell_size_.second * scale.second));
+
+    // Sparse grids, or positions far from the samples, would need more cell
+    // lookups than a scan of all the cells
+    size_t lookups = 0;
+    for (int64_t r = first_ring; r <= last_ring; ++r) {
+        float bound = float(r - 1) * step;
+        if (bound > 0.f and bound * bound > best) {
+            break;
+        }
+        lookups += size_t(std::max<int64_t>(8 * r, 1));
+        if (lookups > cells_.size()) {
+            best = max_squared_distance;
+            found = false;
+            for (const auto& cell : cells_) {
+                visitCell(cell.second);
+            }
+            break;
+        }
+
+        int64_t x_begin = std::max(cx - r, min_x);
+        int64_t x_end = std::min(cx + r, max_x);
+        for (int64_t y : {cy - r, cy + r}) {
+            if (y >= min_y and y <= max_y) {
+                for (int64_t x = x_begin; x <= x_end; ++x) {
+                    visit(x, y);
+                }
+            }
+            if (r == 0) {
+                break;
+            }
+        }
+        if (r == 0) {
+            continue;
+        }
+        int64_t y_begin = std::max(cy - r + 1, min_y);
+        int64_t y_end = std::min(cy + r - 1, max_y);
+        for (int64_t x : {cx - r, cx + r}) {
+            if (x >= min_x and x <= max_x) {
+                for (int64_t y = y_begin; y <= y_end; ++y) {
+                    visit(x, y);
+                }
+            }
+        }
+    }
+    return found;
+}
+
+bool PointGrid::outdated(size_t samples) const {
+    size_t removed = size_ - std::min(size_, samples);
+    return removed > samples or
+           size_ > max_growth * std::max<size_t>(initial_samples_, 64);
+}
+
+PointGrid::Cell PointGrid::cellOf(const PointXY& point) const {
+    auto coordinate = [](float value, float size) {
+        return int32_t(
+            std::min(std::max(std::floor(value / size), -max_cell), max_cell));
+    };
+    return Cell(coordinate(point.first, cell_size_.first),
+                coordinate(point.second, cell_size_.second));
+}
+
+size_t PointGrid::memoryUsage() const {
+    // Hash table nodes hold the next node's pointer and the cached hash in
+    // addition to the cell
+    size_t bytes =
+        cells_.bucket_count() * sizeof(void*) +
+        cells_.size() * (sizeof(decltype(cells_)::value_type) +
+                         2 * sizeof(void*));
+    for (const auto& cell : cells_) {
+        bytes += cell.second.capacity() * sizeof(Entry);
+    }
+    return bytes;
+}
@@ -0,0 +1,176 @@
+/*      File: polyline_clipper.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/polyline_clipper.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace rtp;
+
+PolylineClipper::PolylineClipper(RenderCommandBuffer& commands)
+    : commands_(commands),
+      tolerance_(0.f),
+      has_previous_(false),
+      pending_distance_(0.f),
+      has_pending_(false),
+      has_direction_(false),
+      is_open_(false) {
+}
+
+void PolylineClipper::begin(const PointXY& start, const PointXY& size,
+                            float tolerance) {
+    min_ = start;
+    max_ = PointXY(start.first + size.first, start.second + size.second);
+    tolerance_ = tolerance;
+    has_previous_ = false;
+    has_pending_ = false;
+    has_direction_ = false;
+    is_open_ = false;
+}
+
+void PolylineClipper::addPoint(const PointXY& point) {
+    if (not std::isfinite(point.first) or not std::isfinite(point.second)) {
+        closePolyline();
+        has_previous_ = false;
+        return;
+    }
+    if (not has_previous_) {
+        previous_ = point;
+        has_previous_ = true;
+        return;
+    }
+
+    PointXY start = previous_;
+    PointXY end = point;
+    previous_ = point;
+    if (not clip(start, end)) {
+        closePolyline();
+        return;
+    }
+    // The segment enters the rectangle or follows one that was rejected
+    if (not is_open_ or start != end_of_line_) {
+        closePolyline();
+        openPolyline(start);
+    }
+    merge(end);
+    end_of_line_ = end;
+    // The segment leaves the rectangle
+    if (end != point) {
+        closePolyline();
+    }
+}
+
+void PolylineClipper::end() {
+    closePolyline();
+    has_previous_ = false;
+}
+
+bool PolylineClipper::clip(PointXY& start, PointXY& end) const {
+    float dx = end.first - start.first;
+    float dy = end.second - start.second;
+    float t0 = 0.f;
+    float t1 = 1.f;
+    // Narrow [t0,t1] to the part of the segment on the inner side of a
+    // border. p is the projection of the segment on the border's normal and
+    // q the distance between the start point and the border
+    auto narrow = [&t0, &t1](float p, float q) {
+        if (p == 0.f) {
+            return q >= 0.f;
+        }
+        float t = q / p;
+        if (p < 0.f) {
+            if (t > t1) {
+                return false;
+            }
+            t0 = std::max(t0, t);
+        } else {
+            if (t < t0) {
+                return false;
+            }
+            t1 = std::min(t1, t);
+        }
+        return true;
+    };
+
+    if (not(narrow(-dx, start.first - min_.first) and
+            narrow(dx, max_.first - start.first) and
+            narrow(-dy, start.second - min_.second) and
+            narrow(dy, max_.second - start.second))) {
+        return false;
+    }
+    if (t1 < 1.f) {
+        end = PointXY(start.first + t1 * dx, start.second + t1 * dy);
+    }
+    if (t0 > 0.f) {
+        start = PointXY(start.first + t0 * dx, start.second + t0 * dy);
+    }
+    return true;
+}
+
+void PolylineClipper::openPolyline(const PointXY& point) {
+    commands_.beginPolyline();
+    commands_.addPoint(point);
+    anchor_ = point;
+    end_of_line_ = point;
+    has_pending_ = false;
+    has_direction_ = false;
+    is_open_ = true;
+}
+
+void PolylineClipper::closePolyline() {
+    if (is_open_ and has_pending_) {
+        commands_.addPoint(pending_);
+    }
+    has_pending_ = false;
+    has_direction_ = false;
+    is_open_ = false;
+}
+
+void PolylineClipper::merge(const PointXY& point) {
+    if (has_direction_) {
+        float dx = point.first - anchor_.first;
+        float dy = point.second - anchor_.second;
+        float along = dx * direction_.first + dy * direction_.second;
+        float across = std::abs(dx * direction_.second - dy * direction_.first);
+        if (across <= tolerance_ and along >= pending_distance_ - tolerance_) {
+            if (along > pending_distance_) {
+                pending_ = point;
+                pending_distance_ = along;
+            }
+            return;
+        }
+        commands_.addPoint(pending_);
+        anchor_ = pending_;
+        has_direction_ = false;
+    }
+
+    // Points closer than the tolerance to the anchor replace each other until
+    // one is far enough to give the direction of the next run
+    float dx = point.first - anchor_.first;
+    float dy = point.second - anchor_.second;
+    float distance = std::sqrt(dx * dx + dy * dy);
+    pending_ = point;
+    has_pending_ = true;
+    if (distance > tolerance_) {
+        direction_ = PointXY(dx / distance, dy / distance);
+        pending_distance_ = distance;
+        has_direction_ = true;
+    }
+}
@@ -0,0 +1,132 @@
+/*      File: refresh_scheduler.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/refresh_scheduler.h>
+
+using namespace rtp;
+
+RefreshScheduler::RefreshScheduler(std::function<void()> redraw)
+    : redraw_(std::move(redraw)),
+      dirty_(false),
+      stop_(true),
+      period_(0),
+      min_interval_(0),
+      refreshes_(0),
+      missed_deadlines_(0) {
+}
+
+RefreshScheduler::~RefreshScheduler() {
+    stop();
+}
+
+void RefreshScheduler::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_) {
+        stop_ = false;
+        last_redraw_ = clock::time_point{};
+        next_periodic_redraw_ = clock::now() + period_;
+        thread_ = std::thread(&RefreshScheduler::process, this);
+    }
+}
+
+void RefreshScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void RefreshScheduler::requestRefresh() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (dirty_) {
+            return;
+        }
+        dirty_ = true;
+    }
+    cv_.notify_one();
+}
+
+void RefreshScheduler::setPeriod(std::chrono::milliseconds period) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        period_ = period;
+        next_periodic_redraw_ = clock::now() + period_;
+    }
+    cv_.notify_one();
+}
+
+void RefreshScheduler::setMinInterval(std::chrono::microseconds interval) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        min_interval_ = interval;
+    }
+    cv_.notify_one();
+}
+
+uint64_t RefreshScheduler::refreshes() const {
+    return refreshes_.load(std::memory_order_relaxed);
+}
+
+uint64_t RefreshScheduler::missedDeadlines() const {
+    return missed_deadlines_.load(std::memory_order_relaxed);
+}
+
+void RefreshScheduler::process() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (not stop_) {
+        auto now = clock::now();
+        bool periodic = period_.count() > 0 and now >= next_periodic_redraw_;
+
+        if (not dirty_ and not periodic) {
+            if (period_.count() > 0) {
+                cv_.wait_until(lock, next_periodic_redraw_);
+            } else {
+                cv_.wait(lock);
+            }
+            continue;
+        }
+
+        auto earliest = last_redraw_ + min_interval_;
+        if (now < earliest) {
+            cv_.wait_until(lock, earliest, [this] { return stop_; });
+            continue;
+        }
+
+        if (periodic) {
+            // Don't try to catch up with the missed periods, only count them
+            next_periodic_redraw_ += period_;
+            if (next_periodic_redraw_ <= now) {
+                missed_deadlines_.fetch_add(1, std::memory_order_relaxed);
+                next_periodic_redraw_ = now + period_;
+            }
+        }
+
+        dirty_ = false;
+        last_redraw_ = now;
+        lock.unlock();
+        redraw_();
+        refreshes_.fetch_add(1, std::memory_order_relaxed);
+        lock.lock();
+    }
+}
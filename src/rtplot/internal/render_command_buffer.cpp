@@ -0,0 +1,146 @@
+/*      File: render_command_buffer.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/render_command_buffer.h>
+
+using namespace rtp;
+
+RenderCommandBuffer::RenderCommandBuffer() : text_count_(0), image_count_(0) {
+}
+
+void RenderCommandBuffer::clear() {
+    commands_.clear();
+    points_.clear();
+    text_count_ = 0;
+    image_count_ = 0;
+}
+
+void RenderCommandBuffer::pushClip(const PointXY& start, const PointXY& size) {
+    add(Op::PushClip, 0, points_.size(), 2);
+    points_.push_back(start);
+    points_.push_back(size);
+}
+
+void RenderCommandBuffer::popClip() {
+    add(Op::PopClip);
+}
+
+void RenderCommandBuffer::startLine() {
+    add(Op::StartLine);
+}
+
+void RenderCommandBuffer::endLine() {
+    add(Op::EndLine);
+}
+
+void RenderCommandBuffer::setLineStyle(int style) {
+    add(Op::SetLineStyle, style);
+}
+
+void RenderCommandBuffer::setColor(Colors color) {
+    add(Op::SetColor, static_cast<int32_t>(color));
+}
+
+void RenderCommandBuffer::saveColor() {
+    add(Op::SaveColor);
+}
+
+void RenderCommandBuffer::restoreColor() {
+    add(Op::RestoreColor);
+}
+
+void RenderCommandBuffer::line(const PointXY& start, const PointXY& end) {
+    beginPolyline();
+    addPoint(start);
+    addPoint(end);
+}
+
+void RenderCommandBuffer::beginPolyline() {
+    add(Op::Polyline, 0, points_.size(), 0);
+}
+
+void RenderCommandBuffer::addPoint(const PointXY& point) {
+    points_.push_back(point);
+    ++commands_.back().count;
+}
+
+void RenderCommandBuffer::text(const std::string& text,
+                               const PointXY& position,
+                               const PointXY& width_offset,
+                               const PointXY& height_offset, int angle) {
+    if (text_count_ < texts_.size()) {
+        texts_[text_count_].assign(text);
+    } else {
+        texts_.push_back(text);
+    }
+    add(Op::DrawText, angle, points_.size(), text_count_++);
+    points_.push_back(position);
+    points_.push_back(width_offset);
+    points_.push_back(height_offset);
+}
+
+uint8_t* RenderCommandBuffer::image(const PointXY& position, size_t width,
+                                    size_t height) {
+    if (image_count_ == images_.size()) {
+        images_.emplace_back();
+    }
+    auto& pixels = images_[image_count_];
+    pixels.resize(width * height);
+    add(Op::DrawImage, 0, points_.size(), image_count_++);
+    points_.push_back(position);
+    points_.push_back(PointXY(float(width), float(height)));
+    return pixels.data();
+}
+
+const std::vector<RenderCommandBuffer::Command>&
+RenderCommandBuffer::commands() const {
+    return commands_;
+}
+
+const std::vector<RenderCommandBuffer::PointXY>&
+RenderCommandBuffer::points() const {
+    return points_;
+}
+
+const std::string& RenderCommandBuffer::text(size_t index) const {
+    return texts_[index];
+}
+
+const uint8_t* RenderCommandBuffer::image(size_t index) const {
+    return images_[index].data();
+}
+
+size_t RenderCommandBuffer::memoryUsage() const {
+    size_t bytes = commands_.capacity() * sizeof(Command) +
+                   points_.capacity() * sizeof(PointXY) +
+                   texts_.capacity() * sizeof(std::string);
+    for (const auto& text : texts_) {
+        bytes += text.capacity();
+    }
+    bytes += images_.capacity() * sizeof(std::vector<uint8_t>);
+    for (const auto& image : images_) {
+        bytes += image.capacity();
+    }
+    return bytes;
+}
+
+void RenderCommandBuffer::add(Op op, int32_t arg, uint32_t index,
+                              uint32_t count) {
+    commands_.push_back(Command{op, arg, index, count});
+}
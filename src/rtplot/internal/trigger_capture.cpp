@@ -0,0 +1,154 @@
+/*      File: trigger_capture.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/trigger_capture.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <limits>
+
+using namespace rtp;
+
+namespace {
+
+// Number of sweeps allocated in addition to the retained ones and the one
+// being captured, to cover the ones still referenced by the short lived
+// snapshots
+constexpr size_t spare_sweeps = 2;
+
+std::shared_ptr<TriggerSweep> newSweep(size_t points) {
+    auto sweep = std::make_shared<TriggerSweep>();
+    sweep->points.reserve(points);
+    return sweep;
+}
+
+} // namespace
+
+TriggerCapture::TriggerCapture(TriggerMode mode, float level,
+                               size_t pre_samples, size_t post_samples,
+                               size_t max_sweeps)
+    : mode_(mode),
+      level_(level),
+      pre_samples_(pre_samples),
+      post_samples_(post_samples),
+      max_sweeps_(max_sweeps),
+      previous_y_(0.f),
+      has_previous_(false),
+      pool_size_(2 * max_sweeps + 1 + spare_sweeps),
+      captures_(0) {
+    assert(max_sweeps > 0);
+    history_.reserve(pre_samples);
+    sweeps_.reserve(max_sweeps);
+    spare_.reserve(pool_size_);
+    while (spare_.size() < pool_size_) {
+        spare_.push_back(newSweep(pre_samples + 1 + post_samples));
+    }
+}
+
+void TriggerCapture::reset() {
+    history_.clear();
+    has_previous_ = false;
+    if (capture_) {
+        release(std::move(capture_));
+    }
+}
+
+size_t TriggerCapture::memoryUsage() const {
+    size_t bytes = history_.capacity() * sizeof(PointXY);
+    auto add = [&bytes](const std::shared_ptr<TriggerSweep>& sweep) {
+        bytes += sizeof(TriggerSweep) +
+                 sweep->points.capacity() * sizeof(PointXY);
+    };
+    for (size_t i = 0; i < sweeps_.size(); ++i) {
+        add(sweeps_[i]);
+    }
+    std::for_each(spare_.begin(), spare_.end(), add);
+    if (capture_) {
+        add(capture_);
+    }
+    return bytes;
+}
+
+void TriggerCapture::start(float x, float y) {
+    capture_ = makeSweep();
+    auto& sweep = *capture_;
+    sweep.points.clear();
+    sweep.trigger_x = x;
+    sweep.xmin = sweep.ymin = std::numeric_limits<float>::infinity();
+    sweep.xmax = sweep.ymax = -std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i < history_.size(); ++i) {
+        const auto& point = history_[i];
+        add(point.first, point.second);
+    }
+    sweep.trigger_index = history_.size();
+    append(x, y);
+}
+
+void TriggerCapture::add(float x, float y) {
+    auto& sweep = *capture_;
+    sweep.points.push_back(PointXY(x, y));
+    float relative_x = x - sweep.trigger_x;
+    sweep.xmin = std::min(sweep.xmin, relative_x);
+    sweep.xmax = std::max(sweep.xmax, relative_x);
+    sweep.ymin = std::min(sweep.ymin, y);
+    sweep.ymax = std::max(sweep.ymax, y);
+}
+
+void TriggerCapture::append(float x, float y) {
+    add(x, y);
+    // The triggering sample followed by post_samples_ ones
+    const auto& sweep = *capture_;
+    if (sweep.points.size() == sweep.trigger_index + 1 + post_samples_) {
+        complete();
+    }
+}
+
+void TriggerCapture::complete() {
+    if (sweeps_.size() == max_sweeps_) {
+        release(std::move(sweeps_.front()));
+        sweeps_.pop_front();
+    }
+    sweeps_.push_back(std::move(capture_));
+    ++captures_;
+}
+
+std::shared_ptr<TriggerSweep> TriggerCapture::makeSweep() {
+    // A sweep can only be reused once no snapshot references it anymore. The
+    // fence pairs with the release performed by the snapshot's shared_ptr
+    // destructor
+    for (size_t i = spare_.size(); i > 0; --i) {
+        if (spare_[i - 1].use_count() == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            std::swap(spare_[i - 1], spare_.back());
+            auto sweep = std::move(spare_.back());
+            spare_.pop_back();
+            return sweep;
+        }
+    }
+    return newSweep(pre_samples_ + 1 + post_samples_);
+}
+
+void TriggerCapture::release(std::shared_ptr<TriggerSweep> sweep) {
+    // Sweeps still referenced by a snapshot are kept in the pool too so that
+    // they can be reused once the snapshot is released
+    if (spare_.size() < pool_size_) {
+        spare_.push_back(std::move(sweep));
+    }
+}
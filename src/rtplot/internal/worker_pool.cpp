@@ -0,0 +1,101 @@
+/*      File: worker_pool.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/worker_pool.h>
+
+#include <algorithm>
+
+using namespace rtp;
+
+WorkerPool::WorkerPool(size_t threads)
+    : task_(nullptr),
+      task_count_(0),
+      next_task_(0),
+      pending_tasks_(0),
+      generation_(0),
+      stop_(false) {
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back(&WorkerPool::process, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+    work_available_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkerPool::parallelFor(size_t count,
+                             const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(lock_);
+    task_ = &task;
+    task_count_ = count;
+    next_task_ = 0;
+    pending_tasks_ = count;
+    ++generation_;
+    if (count > 1) {
+        work_available_.notify_all();
+    }
+
+    runTasks(lock);
+    work_done_.wait(lock, [this] { return pending_tasks_ == 0; });
+    task_ = nullptr;
+}
+
+size_t WorkerPool::defaultThreadCount() {
+    size_t cores = std::thread::hardware_concurrency();
+    return std::min<size_t>(cores > 1 ? cores - 1 : 0, 4);
+}
+
+void WorkerPool::process() {
+    std::unique_lock<std::mutex> lock(lock_);
+    size_t last_generation = generation_;
+    while (true) {
+        work_available_.wait(lock, [this, last_generation] {
+            return stop_ or generation_ != last_generation;
+        });
+        if (stop_) {
+            return;
+        }
+        last_generation = generation_;
+        runTasks(lock);
+    }
+}
+
+void WorkerPool::runTasks(std::unique_lock<std::mutex>& lock) {
+    while (task_ and next_task_ < task_count_) {
+        size_t idx = next_task_++;
+        auto& task = *task_;
+        lock.unlock();
+        task(idx);
+        lock.lock();
+        if (--pending_tasks_ == 0) {
+            work_done_.notify_all();
+        }
+    }
+}
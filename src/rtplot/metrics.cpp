@@ -0,0 +1,226 @@
+/*      File: metrics.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/metrics.h>
+
+#include <ostream>
+#include <algorithm>
+
+using namespace rtp;
+
+constexpr size_t DurationDistribution::bucket_count;
+
+namespace {
+
+size_t bucketIndex(uint64_t ns) {
+    size_t idx = 0;
+    while (ns > 1 and idx < DurationDistribution::bucket_count - 1) {
+        ns >>= 1;
+        ++idx;
+    }
+    return idx;
+}
+
+void printDuration(std::ostream& out, double ns) {
+    auto flags = out.flags();
+    auto precision = out.precision(1);
+    out << std::fixed;
+    if (ns < 1e3) {
+        out << ns << "ns";
+    } else if (ns < 1e6) {
+        out << ns / 1e3 << "us";
+    } else {
+        out << ns / 1e6 << "ms";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+} // namespace
+
+DurationDistribution::DurationDistribution()
+    : count(0), total_ns(0), max_ns(0) {
+    buckets.fill(0);
+}
+
+double DurationDistribution::mean() const {
+    return count ? double(total_ns) / double(count) : 0.;
+}
+
+uint64_t DurationDistribution::percentile(double ratio) const {
+    uint64_t target = static_cast<uint64_t>(ratio * count);
+    uint64_t cumulated = 0;
+    for (size_t i = 0; i < bucket_count; ++i) {
+        cumulated += buckets[i];
+        if (cumulated > target) {
+            return std::min(max_ns, (uint64_t(1) << (i + 1)) - 1);
+        }
+    }
+    return max_ns;
+}
+
+DurationHistogram::DurationHistogram() {
+    reset();
+}
+
+void DurationHistogram::record(std::chrono::nanoseconds duration) {
+    auto ns = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+    buckets_[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_ns_.fetch_add(ns, std::memory_order_relaxed);
+    auto max_ns = max_ns_.load(std::memory_order_relaxed);
+    while (ns > max_ns and
+           not max_ns_.compare_exchange_weak(max_ns, ns,
+                                             std::memory_order_relaxed)) {
+    }
+}
+
+DurationDistribution DurationHistogram::read() const {
+    DurationDistribution dist;
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+        dist.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    dist.count = count_.load(std::memory_order_relaxed);
+    dist.total_ns = total_ns_.load(std::memory_order_relaxed);
+    dist.max_ns = max_ns_.load(std::memory_order_relaxed);
+    return dist;
+}
+
+void DurationHistogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    total_ns_.store(0, std::memory_order_relaxed);
+    max_ns_.store(0, std::memory_order_relaxed);
+}
+
+MemoryUsage::MemoryUsage()
+    : samples(0), compressed(0), indexes(0), rendering(0), other(0) {
+}
+
+size_t MemoryUsage::total() const {
+    return samples + compressed + indexes + rendering + other;
+}
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& other_usage) {
+    samples += other_usage.samples;
+    compressed += other_usage.compressed;
+    indexes += other_usage.indexes;
+    rendering += other_usage.rendering;
+    other += other_usage.other;
+    return *this;
+}
+
+CurveStatistics::CurveStatistics()
+    : count(0), mean(0.), rms(0.), stddev(0.), min(0.f), max(0.f) {
+}
+
+PlotMetrics::PlotMetrics()
+    : points_per_second(0.), points_added(0), points_evicted(0), frames(0) {
+}
+
+WindowMetrics::WindowMetrics() : refreshes(0), missed_deadlines(0) {
+}
+
+PhaseTimings::PhaseTimings() : mean_ns(0.), p99_ns(0), samples(0) {
+}
+
+FrameProfile::FrameProfile() : enabled(false) {
+}
+
+std::ostream& rtp::operator<<(std::ostream& out,
+                              const DurationDistribution& dist) {
+    out << "count: " << dist.count << ", mean: ";
+    printDuration(out, dist.mean());
+    out << ", p50: ";
+    printDuration(out, double(dist.percentile(0.5)));
+    out << ", p99: ";
+    printDuration(out, double(dist.percentile(0.99)));
+    out << ", max: ";
+    printDuration(out, double(dist.max_ns));
+    return out;
+}
+
+std::ostream& rtp::operator<<(std::ostream& out,
+                              const CurveStatistics& stats) {
+    return out << "count: " << stats.count << ", mean: " << stats.mean
+               << ", rms: " << stats.rms << ", stddev: " << stats.stddev
+               << ", min: " << stats.min << ", max: " << stats.max;
+}
+
+std::ostream& rtp::operator<<(std::ostream& out, const MemoryUsage& usage) {
+    return out << "total: " << usage.total() << "B, samples: " << usage.samples
+               << "B, compressed: " << usage.compressed
+               << "B, indexes: " << usage.indexes
+               << "B, rendering: " << usage.rendering
+               << "B, other: " << usage.other << "B";
+}
+
+std::ostream& rtp::operator<<(std::ostream& out, const PlotMetrics& metrics) {
+    out << "points/s: " << static_cast<uint64_t>(metrics.points_per_second)
+        << ", added: " << metrics.points_added
+        << ", evicted: " << metrics.points_evicted
+        << ", frames: " << metrics.frames << '\n';
+    out << "  draw duration: " << metrics.draw_duration << '\n';
+    out << "  lock wait: " << metrics.lock_wait << '\n';
+    for (const auto& curve : metrics.curves) {
+        out << "  curve " << curve.curve << ": samples: " << curve.samples
+            << ", memory: " << curve.memory_bytes << "B"
+            << ", added: " << curve.points_added
+            << ", evicted: " << curve.points_evicted << '\n';
+    }
+    return out;
+}
+
+std::ostream& rtp::operator<<(std::ostream& out,
+                              const WindowMetrics& metrics) {
+    out << "refreshes: " << metrics.refreshes
+        << ", missed deadlines: " << metrics.missed_deadlines << '\n';
+    for (size_t i = 0; i < metrics.plots.size(); ++i) {
+        out << "plot " << i << ": " << metrics.plots[i];
+    }
+    return out;
+}
+
+std::ostream& rtp::operator<<(std::ostream& out, const FrameProfile& profile) {
+    static const char* phase_names[frame_phase_count] = {
+        "prepare",    "snapshot", "labels toggle", "labels",     "axes",
+        "scale init", "curves",   "replay",        "cursor text"};
+
+    if (not profile.enabled) {
+        return out << "frame profiler disabled\n";
+    }
+    auto print = [&out](const PhaseTimings& timings) {
+        out << "mean: ";
+        printDuration(out, timings.mean_ns);
+        out << ", p99: ";
+        printDuration(out, double(timings.p99_ns));
+        out << " (" << timings.samples << " frames)\n";
+    };
+    for (size_t i = 0; i < frame_phase_count; ++i) {
+        out << phase_names[i] << ": ";
+        print(profile.phases[i]);
+    }
+    for (const auto& curve : profile.curves) {
+        out << "  curve " << curve.first << ": ";
+        print(curve.second);
+    }
+    return out;
+}
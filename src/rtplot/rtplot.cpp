@@ -25,34 +25,57 @@
 #include <X11/Xlib.h>
 
 #include <iostream>
+#include <ostream>
 #include <chrono>
+#include <algorithm>
 
 using namespace std;
 using namespace rtp;
 
-namespace {
-mutex refresh_mtx;
-}
-
 RTPlot::RTPlot() {
     impl_ = std::make_unique<RTPlot::rtplot_members>();
+    impl_->scheduler_ = std::make_unique<RefreshScheduler>([this] {
+        preparePlots();
+        redraw();
+        adaptRefreshRate();
+    });
+    setMaxFrameRate(60);
 }
 
 void RTPlot::init() {
     create();
     impl_->window_->show();
+    impl_->scheduler_->start();
 }
 
 RTPlot::~RTPlot() {
     quit();
 }
 
-void RTPlot::checkPlot(size_t plot) {
-    assert(plot < impl_->grid_rows_ * impl_->grid_cols_);
-    if (not static_cast<bool>(impl_->plots_[plot])) {
-        impl_->plots_[plot] = makePlot();
+RTPlotCore& RTPlot::checkPlot(size_t plot) {
+    // Fast path for the producers, the plot already exists
+    auto plot_ptrs = impl_->plot_ptrs_.load(std::memory_order_acquire);
+    assert(plot_ptrs != nullptr and plot < plot_ptrs->size());
+    auto ptr = (*plot_ptrs)[plot].load(std::memory_order_acquire);
+    if (ptr) {
+        return *ptr;
+    }
+
+    std::lock_guard<std::mutex> lock(impl_->plots_lock_);
+    assert(plot < impl_->plots_.size());
+    if (not impl_->plots_[plot]) {
+        auto new_plot = makePlot();
+        if (impl_->frame_budget_ms_ > 0.f) {
+            new_plot->setFrameBudget(
+                impl_->frame_budget_ms_ /
+                float(impl_->grid_rows_ * impl_->grid_cols_));
+        }
+        impl_->plots_[plot] = new_plot;
+        (*impl_->plot_ptrs_.load())[plot].store(new_plot.get(),
+                                                std::memory_order_release);
         updateLayout();
     }
+    return *impl_->plots_[plot];
 }
 
 void RTPlot::updateLayout() {
@@ -63,9 +86,23 @@ void RTPlot::updateLayout() {
 
 void RTPlot::setGridSize(size_t rows, size_t cols) {
     assert((rows >= 1) and (cols >= 1));
+    std::lock_guard<std::mutex> lock(impl_->plots_lock_);
     impl_->grid_rows_ = rows;
     impl_->grid_cols_ = cols;
+    // The producers may still be reading the previous table or using the
+    // removed plots, so they are kept alive
+    for (size_t i = rows * cols; i < impl_->plots_.size(); ++i) {
+        if (impl_->plots_[i]) {
+            impl_->removed_plots_.push_back(std::move(impl_->plots_[i]));
+        }
+    }
     impl_->plots_.resize(rows * cols);
+    auto plot_ptrs = std::make_unique<rtplot_members::PlotPtrs>(rows * cols);
+    for (size_t i = 0; i < plot_ptrs->size(); ++i) {
+        (*plot_ptrs)[i] = impl_->plots_[i].get();
+    }
+    impl_->plot_ptrs_.store(plot_ptrs.get(), std::memory_order_release);
+    impl_->plot_ptrs_tables_.push_back(std::move(plot_ptrs));
     impl_->window_->setMinimumSize(cols * getPlotWidth(),
                                    rows * getPlotHeight());
     updateLayout();
@@ -75,123 +112,223 @@ void RTPlot::quit() {
     // if(impl_->parser_)
     //  impl_->parser_->stop();
     disableAutoRefresh();
+    impl_->scheduler_->stop();
     // impl_->window_->hide();
 }
 
 void RTPlot::addPoint(size_t plot, int curve, float x, float y) {
-    checkPlot(plot);
-    impl_->plots_[plot]->addPoint(curve, x, y);
+    checkPlot(plot).addPoint(curve, x, y);
 }
 
 void RTPlot::removeFirstPoint(size_t plot, int curve) {
-    checkPlot(plot);
-    impl_->plots_[plot]->removeFirstPoint(curve);
+    checkPlot(plot).removeFirstPoint(curve);
+}
+
+CurveHandle RTPlot::getCurveHandle(size_t plot, int curve) {
+    return checkPlot(plot).getCurveHandle(curve);
+}
+
+void RTPlot::addPoints(size_t plot, int curve, const float* xs,
+                       const float* ys, size_t count) {
+    checkPlot(plot).addPoints(curve, xs, ys, count);
+}
+
+void RTPlot::addSample(size_t plot, int curve, float y) {
+    checkPlot(plot).addSample(curve, y);
+}
+
+void RTPlot::addSamples(size_t plot, int curve, const float* ys,
+                        size_t count) {
+    checkPlot(plot).addSamples(curve, ys, count);
+}
+
+void RTPlot::addFrame(size_t plot, float x, const float* ys, size_t count) {
+    checkPlot(plot).addFrame(x, ys, count);
+}
+
+void RTPlot::attachCurve(size_t plot, size_t source_plot, int curve) {
+    checkPlot(plot).attachCurve(checkPlot(source_plot), curve);
+    refresh();
+}
+
+void RTPlot::setUniformSampling(size_t plot, int curve, float x0, float dx) {
+    checkPlot(plot).setUniformSampling(curve, x0, dx);
+}
+
+void RTPlot::setIngestionFilter(size_t plot, int curve,
+                                IngestionFilter filter, size_t factor) {
+    checkPlot(plot).setIngestionFilter(curve, filter, factor);
+}
+
+void RTPlot::setTrigger(size_t plot, int curve, TriggerMode mode, float level,
+                        size_t pre_samples, size_t post_samples,
+                        size_t sweeps) {
+    checkPlot(plot).setTrigger(curve, mode, level, pre_samples, post_samples,
+                               sweeps);
+}
+
+void RTPlot::removeTrigger(size_t plot, int curve) {
+    checkPlot(plot).removeTrigger(curve);
+}
+
+void RTPlot::setDifferenceCurve(size_t plot, int curve, int lhs, int rhs) {
+    checkPlot(plot).setDifferenceCurve(curve, lhs, rhs);
+}
+
+void RTPlot::setScaledCurve(size_t plot, int curve, int source, float gain,
+                            float offset) {
+    checkPlot(plot).setScaledCurve(curve, source, gain, offset);
+}
+
+void RTPlot::setMovingAverageCurve(size_t plot, int curve, int source,
+                                   size_t window) {
+    checkPlot(plot).setMovingAverageCurve(curve, source, window);
+}
+
+void RTPlot::setSpectrumCurve(size_t plot, int curve, int source,
+                              size_t samples) {
+    checkPlot(plot).setSpectrumCurve(curve, source, samples);
+}
+
+void RTPlot::removeDerivedCurve(size_t plot, int curve) {
+    checkPlot(plot).removeDerivedCurve(curve);
+}
+
+void RTPlot::enableCompression(size_t plot, int curve, size_t raw_samples) {
+    checkPlot(plot).enableCompression(curve, raw_samples);
+}
+
+void RTPlot::disableCompression(size_t plot, int curve) {
+    checkPlot(plot).disableCompression(curve);
+}
+
+void RTPlot::reserve(size_t plot, int curve, size_t count) {
+    checkPlot(plot).reserve(curve, count);
 }
 
 void RTPlot::setXLabel(size_t plot, const std::string& name) {
-    checkPlot(plot);
-    impl_->plots_[plot]->setXLabel(name);
+    checkPlot(plot).setXLabel(name);
     refresh();
 }
 
 void RTPlot::setYLabel(size_t plot, const std::string& name) {
-    checkPlot(plot);
-    impl_->plots_[plot]->setYLabel(name);
+    checkPlot(plot).setYLabel(name);
     refresh();
 }
 
 void RTPlot::setCurveLabel(size_t plot, int curve, const std::string& name) {
-    checkPlot(plot);
-    impl_->plots_[plot]->setCurveLabel(curve, name);
+    checkPlot(plot).setCurveLabel(curve, name);
     refresh();
 }
 
 void RTPlot::setPlotName(size_t plot, const std::string& name) {
-    checkPlot(plot);
-    impl_->plots_[plot]->setPlotName(name);
+    checkPlot(plot).setPlotName(name);
     refresh();
 }
 
 void RTPlot::refresh() {
-    std::lock_guard<std::mutex> lock(refresh_mtx);
-    redraw();
+    impl_->scheduler_->requestRefresh();
 }
 
 void RTPlot::enableAutoRefresh(uint period_ms) {
-    bool create_thread = (impl_->auto_refresh_period_ == 0);
-    impl_->auto_refresh_period_ = period_ms;
-
-    if (create_thread) {
-        impl_->auto_refresh_thread_ = thread([this]() {
-            while (impl_->auto_refresh_period_) {
-                using namespace std::chrono;
-                auto start = high_resolution_clock::now();
-                refresh_mtx.lock();
-                redraw();
-                refresh_mtx.unlock();
-                this_thread::sleep_until(
-                    start + milliseconds(impl_->auto_refresh_period_));
+    impl_->scheduler_->setPeriod(chrono::milliseconds(period_ms));
+}
+
+void RTPlot::disableAutoRefresh() {
+    impl_->scheduler_->setPeriod(chrono::milliseconds(0));
+}
+
+void RTPlot::setMaxFrameRate(size_t fps) {
+    impl_->min_refresh_interval_us_ = fps ? 1000000 / fps : 0;
+    impl_->scheduler_->setMinInterval(chrono::microseconds(
+        impl_->min_refresh_interval_us_ * impl_->refresh_slowdown_));
+}
+
+void RTPlot::preparePlots() {
+    auto& plots = impl_->plots_to_prepare_;
+    {
+        std::lock_guard<std::mutex> lock(impl_->plots_lock_);
+        plots.clear();
+        for (auto& plot : impl_->plots_) {
+            if (plot) {
+                plots.push_back(plot);
             }
-        });
+        }
     }
+
+    impl_->workers_.parallelFor(
+        plots.size(), [&plots](size_t i) { plots[i]->prepareFrame(); });
+    plots.clear();
 }
 
-void RTPlot::disableAutoRefresh() {
-    if (impl_->auto_refresh_period_) {
-        impl_->auto_refresh_period_ = 0;
-        impl_->auto_refresh_thread_.join();
+void RTPlot::adaptRefreshRate() {
+    auto lowest_quality = QualityLevel::Full;
+    std::unique_lock<std::mutex> lock(impl_->plots_lock_);
+    for (auto& plot : impl_->plots_) {
+        if (plot) {
+            lowest_quality = std::max(lowest_quality, plot->getQualityLevel());
+        }
+    }
+    lock.unlock();
+
+    size_t slowdown = 1;
+    if (lowest_quality == QualityLevel::Reduced) {
+        slowdown = 2;
+    } else if (lowest_quality == QualityLevel::Minimal) {
+        slowdown = 4;
+    }
+
+    if (slowdown != impl_->refresh_slowdown_) {
+        impl_->refresh_slowdown_ = slowdown;
+        impl_->scheduler_->setMinInterval(
+            chrono::microseconds(impl_->min_refresh_interval_us_ * slowdown));
     }
 }
 
 void RTPlot::setXRange(size_t plot, float min, float max) {
-    checkPlot(plot);
-    impl_->plots_[plot]->setXRange(min, max);
+    checkPlot(plot).setXRange(min, max);
     refresh();
 }
 
 void RTPlot::setYRange(size_t plot, float min, float max) {
-    checkPlot(plot);
-    impl_->plots_[plot]->setYRange(min, max);
+    checkPlot(plot).setYRange(min, max);
     refresh();
 }
 
 void RTPlot::autoXRange(size_t plot) {
-    checkPlot(plot);
-    impl_->plots_[plot]->setAutoXRange();
+    checkPlot(plot).setAutoXRange();
     refresh();
 }
 
 void RTPlot::autoYRange(size_t plot) {
-    checkPlot(plot);
-    impl_->plots_[plot]->setAutoYRange();
+    checkPlot(plot).setAutoYRange();
     refresh();
 }
 
 void RTPlot::setMaxPoints(size_t plot, size_t count) {
-    checkPlot(plot);
-    impl_->plots_[plot]->setMaxPoints(count);
+    checkPlot(plot).setMaxPoints(count);
     refresh();
 }
 
 void RTPlot::setColorPalette(const std::vector<Colors>& palette) {
+    std::lock_guard<std::mutex> lock(impl_->plots_lock_);
     for (auto& plot : impl_->plots_) {
-        plot->setColorPalette(palette);
+        if (plot) {
+            plot->setColorPalette(palette);
+        }
     }
 }
 
 void RTPlot::setColorPalette(size_t plot, const std::vector<Colors>& palette) {
-    checkPlot(plot);
-    impl_->plots_[plot]->setColorPalette(palette);
+    checkPlot(plot).setColorPalette(palette);
 }
 
 const std::vector<Colors>& RTPlot::getColorPalette(size_t plot) {
-    checkPlot(plot);
-    return impl_->plots_[plot]->getColorPalette();
+    return checkPlot(plot).getColorPalette();
 }
 
 void RTPlot::setCurveVisibility(size_t plot, int curve, bool visibility) {
-    checkPlot(plot);
-    impl_->plots_[plot]->setCurveVisibility(curve, visibility);
+    checkPlot(plot).setCurveVisibility(curve, visibility);
 }
 
 bool RTPlot::getCurveVisibility(size_t plot, int curve) const {
@@ -203,21 +340,123 @@ void RTPlot::toggleCurveVisibility(size_t plot, int curve) {
 }
 
 void RTPlot::enableFastPlotting(size_t plot) {
-    impl_->plots_.at(plot)->enableFastPlotting();
+    checkPlot(plot).enableFastPlotting();
 }
 
 void RTPlot::enableFastPlotting() {
+    std::lock_guard<std::mutex> lock(impl_->plots_lock_);
     for (auto& plot : impl_->plots_) {
-        plot->enableFastPlotting();
+        if (plot) {
+            plot->enableFastPlotting();
+        }
     }
 }
 
 void RTPlot::disableFastPlotting(size_t plot) {
-    impl_->plots_.at(plot)->disableFastPlotting();
+    checkPlot(plot).disableFastPlotting();
 }
 
 void RTPlot::disableFastPlotting() {
+    std::lock_guard<std::mutex> lock(impl_->plots_lock_);
+    for (auto& plot : impl_->plots_) {
+        if (plot) {
+            plot->disableFastPlotting();
+        }
+    }
+}
+
+void RTPlot::enableStatistics(size_t plot, bool display) {
+    checkPlot(plot).enableStatistics(display);
+}
+
+void RTPlot::disableStatistics(size_t plot) {
+    checkPlot(plot).disableStatistics();
+}
+
+CurveStatistics RTPlot::getStatistics(size_t plot, int curve) {
+    return checkPlot(plot).getStatistics(curve);
+}
+
+void RTPlot::enableDensityPlotting(size_t plot, float persistence) {
+    checkPlot(plot).enableDensityPlotting(persistence);
+}
+
+void RTPlot::disableDensityPlotting(size_t plot) {
+    checkPlot(plot).disableDensityPlotting();
+}
+
+void RTPlot::freeze(size_t plot) {
+    checkPlot(plot).freeze();
+}
+
+void RTPlot::resume(size_t plot) {
+    checkPlot(plot).resume();
+}
+
+PlotMetrics RTPlot::getMetrics(size_t plot) {
+    return checkPlot(plot).getMetrics();
+}
+
+WindowMetrics RTPlot::getMetrics() {
+    WindowMetrics metrics;
+    metrics.refreshes = impl_->scheduler_->refreshes();
+    metrics.missed_deadlines = impl_->scheduler_->missedDeadlines();
+    std::lock_guard<std::mutex> lock(impl_->plots_lock_);
     for (auto& plot : impl_->plots_) {
-        plot->disableFastPlotting();
+        metrics.plots.push_back(plot ? plot->getMetrics() : PlotMetrics{});
     }
+    return metrics;
+}
+
+MemoryUsage RTPlot::getMemoryUsage(size_t plot, int curve) {
+    return checkPlot(plot).getMemoryUsage(curve);
+}
+
+MemoryUsage RTPlot::getMemoryUsage(size_t plot) {
+    return checkPlot(plot).getMemoryUsage();
+}
+
+MemoryUsage RTPlot::getMemoryUsage() {
+    std::vector<RTPlotCore*> plots;
+    std::lock_guard<std::mutex> lock(impl_->plots_lock_);
+    for (auto& plot : impl_->plots_) {
+        plots.push_back(plot.get());
+    }
+    return RTPlotCore::getMemoryUsage(plots);
+}
+
+void RTPlot::setMemoryBudget(size_t bytes) {
+    RTPlotCore::setMemoryBudget(bytes);
+}
+
+void RTPlot::dumpMetrics(std::ostream& out) {
+    out << getMetrics();
+}
+
+void RTPlot::exportData(size_t plot, std::ostream& out, ExportFormat format) {
+    checkPlot(plot).exportData(out, format);
+}
+
+FrameProfile RTPlot::getFrameProfile(size_t plot) {
+    return checkPlot(plot).getFrameProfile();
+}
+
+void RTPlot::setFrameBudget(float budget_ms) {
+    std::lock_guard<std::mutex> lock(impl_->plots_lock_);
+    impl_->frame_budget_ms_ = budget_ms;
+    float plot_budget_ms =
+        budget_ms / float(impl_->grid_rows_ * impl_->grid_cols_);
+    for (auto& plot : impl_->plots_) {
+        if (plot) {
+            plot->setFrameBudget(plot_budget_ms);
+        }
+    }
+}
+
+void RTPlot::setFrameBudget(size_t plot, float budget_ms) {
+    checkPlot(plot).setFrameBudget(budget_ms);
+}
+
+QualityLevel RTPlot::getQualityLevel(size_t plot) {
+    return checkPlot(plot).getQualityLevel();
 }
@@ -18,23 +18,762 @@
  * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
  */
 #include <rtplot/rtplot_core.h>
+#include <rtplot/internal/cache_aligned.h>
+#include <rtplot/internal/curve_data.h>
+#include <rtplot/internal/curve_snapshot.h>
+#include <rtplot/internal/data_export.h>
+#include <rtplot/internal/density_histogram.h>
+#include <rtplot/internal/derived_curve.h>
+#include <rtplot/internal/frame_profiler.h>
+#include <rtplot/internal/point_grid.h>
+#include <rtplot/internal/polyline_clipper.h>
+#include <rtplot/internal/render_command_buffer.h>
+#include <rtplot/internal/screen_cache.h>
+#include <rtplot/internal/trigger_capture.h>
 
 #include <iostream>
 #include <cassert>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <thread>
 #include <mutex>
 #include <functional>
 
 using namespace rtp;
 
+constexpr size_t RTPlotCore::curve_shards;
+
+struct alignas(cache_line_size) RTPlotCore::CurveShard : CacheAligned {
+    std::mutex lock;
+    std::vector<CurveData*> curves;
+};
+
+struct RTPlotCore::RenderState {
+    // Density image of a curve and the samples already accumulated into it,
+    // see CurveData::first_sample and CurveData::generation
+    struct CurveDensity {
+        DensityHistogram histogram;
+        uint64_t generation;
+        uint64_t next_sample;
+    };
+
+    // Curves as seen at the beginning of the frame being drawn
+    std::vector<CurveSnapshot> frame_curves;
+    // Drawing commands of the current frame, recorded by buildFrame()
+    RenderCommandBuffer commands;
+    // Screen coordinates of the visible curves' uncompressed samples, indexed
+    // by curve, valid for the ranges and layout in screen_transform_
+    std::map<int, ScreenCache> screen_caches;
+    // Density images of the visible curves, indexed by curve. Only filled
+    // when density plotting is enabled
+    std::map<int, CurveDensity> densities;
+    // Snapshots of the sources of the derived curve being evaluated.
+    // Protected by curves_lock_
+    std::vector<CurveSnapshot> derived_sources;
+
+    // Index of a curve's samples used to find the one closest to a position
+    // when its x coordinates are not increasing, and the samples already
+    // inserted into it
+    struct CursorGrid {
+        std::unique_ptr<PointGrid> grid;
+        uint64_t generation;
+        uint64_t next_sample;
+    };
+
+    // Grids of the curves looked up since the previous frame, indexed by
+    // curve. Released once the lookups stop, e.g when the cursor leaves the
+    // plot
+    std::map<int, CursorGrid> cursor_grids;
+    bool cursor_lookups;
+    // Content of the curve being looked up while the plot is not frozen
+    CurveSnapshot lookup;
+};
+
 constexpr int _plot_margin_left = 90;
 constexpr int _plot_margin_top = 30;
 constexpr int _plot_margin_right = 40;
 constexpr int _plot_margin_bottom = 60;
 
+// Maximum distance, in pixels, between a merged point and the drawn line
+constexpr float _line_merge_tolerance = 0.25f;
+
+// Maximum distance, in pixels, between the cursor and the samples whose
+// coordinates are displayed
+constexpr float _cursor_readout_distance = 20.f;
+
+// Zoom applied to a frozen plot by each mouse wheel step
+constexpr float _wheel_zoom_factor = 1.25f;
+
+// Minimal time between two checks of the memory budget by the renderers
+constexpr std::chrono::milliseconds _memory_check_period(100);
+
+namespace {
+
+// Lock a curve and record the time spent waiting for it. Only contended
+// acquisitions are recorded so that producers working on different curves
+// don't write to the shared histogram on each point
+std::unique_lock<PriorityMutex> lockCurve(PriorityMutex& mtx,
+                                          DurationHistogram& histogram) {
+    std::unique_lock<PriorityMutex> lock(mtx, std::try_to_lock);
+    if (not lock.owns_lock()) {
+        auto start = std::chrono::steady_clock::now();
+        lock.lock();
+        histogram.record(std::chrono::steady_clock::now() - start);
+    }
+    return lock;
+}
+
+// Lock a curve, or the series it belongs to. The lock is taken again if the
+// curve joined a series while we were waiting for its own lock
+std::unique_lock<PriorityMutex> lockCurve(CurveData& data,
+                                          DurationHistogram& histogram) {
+    for (;;) {
+        auto& mtx = data.curveLock();
+        auto lock = lockCurve(mtx, histogram);
+        if (&data.curveLock() == &mtx) {
+            return lock;
+        }
+    }
+}
+
+std::unique_lock<PriorityMutex> lockCurve(CurveData& data) {
+    for (;;) {
+        auto& mtx = data.curveLock();
+        std::unique_lock<PriorityMutex> lock(mtx);
+        if (&data.curveLock() == &mtx) {
+            return lock;
+        }
+    }
+}
+
+// Current statistics of a curve, left empty if they are not maintained. Its
+// lock must be held by the caller
+CurveStatistics readStatistics(const CurveData& data) {
+    CurveStatistics stats;
+    if (data.track_statistics and data.statistics.count() > 0) {
+        stats.count = data.statistics.count();
+        stats.mean = data.statistics.mean();
+        stats.rms = data.statistics.rms();
+        stats.stddev = std::sqrt(data.statistics.variance());
+        stats.min = data.y_extrema.min();
+        stats.max = data.y_extrema.max();
+    }
+    return stats;
+}
+
+// Text summarizing the statistics of a curve, displayed below its label
+std::string statisticsText(const CurveStatistics& stats) {
+    char str[96];
+    snprintf(str, sizeof(str), "%.3g +/- %.3g, rms %.3g, [%.3g, %.3g]",
+             stats.mean, stats.stddev, stats.rms, double(stats.min),
+             double(stats.max));
+    return str;
+}
+
+// Reference the current content of a curve. Its lock must be held by the
+// caller
+void captureCurve(const CurveData& data, CurveSnapshot& snapshot) {
+    auto series = data.series.load(std::memory_order_relaxed);
+    data.points.snapshot(snapshot.points);
+    data.values.snapshot(snapshot.values);
+    if (series) {
+        series->x.snapshot(snapshot.xs);
+    }
+    snapshot.is_series = series != nullptr;
+    snapshot.x_increasing = series ? series->x_increasing : data.x_increasing;
+    snapshot.cold_blocks.assign(data.cold_blocks.begin(),
+                                data.cold_blocks.end());
+    snapshot.cold_offset = data.cold_offset;
+    snapshot.cold_size = data.cold_size;
+    snapshot.is_uniform = data.is_uniform;
+    snapshot.x0 = data.x0 + double(data.first_sample) * data.dx;
+    snapshot.dx = data.dx;
+    snapshot.first_sample = data.first_sample;
+    snapshot.generation = data.generation;
+    snapshot.curve = data.id;
+    snapshot.label = data.label;
+    snapshot.statistics = readStatistics(data);
+    snapshot.triggered = data.trigger != nullptr;
+    snapshot.sweeps.clear();
+    if (data.trigger) {
+        const auto& sweeps = data.trigger->sweeps();
+        for (size_t i = 0; i < sweeps.size(); ++i) {
+            snapshot.sweeps.push_back(sweeps[i]);
+        }
+    }
+}
+
+// Fill the x extrema of a curve from its samples
+void rebuildXExtrema(CurveData& data) {
+    auto& extrema = data.x_extrema;
+    extrema.clear();
+    if (data.is_uniform or data.series) {
+        return;
+    }
+    std::vector<std::pair<float, float>> decoded;
+    for (size_t i = 0; i < data.cold_blocks.size(); ++i) {
+        data.cold_blocks[i]->decode(decoded);
+        for (size_t j = i ? 0 : data.cold_offset; j < decoded.size(); ++j) {
+            extrema.push(decoded[j].first);
+        }
+    }
+    for (auto point : data.points) {
+        extrema.push(point.first);
+    }
+}
+
+// Compute the statistics of a curve from its samples
+void rebuildStatistics(CurveData& data) {
+    auto& statistics = data.statistics;
+    statistics.clear();
+    std::vector<float> decoded;
+    for (size_t i = 0; i < data.cold_blocks.size(); ++i) {
+        data.cold_blocks[i]->decode(decoded);
+        for (size_t j = i ? 0 : data.cold_offset; j < decoded.size(); ++j) {
+            statistics.push(decoded[j]);
+        }
+    }
+    for (auto point : data.points) {
+        statistics.push(point.second);
+    }
+    for (auto value : data.values) {
+        statistics.push(value);
+    }
+}
+
+// Fill the y extrema of a curve from its samples
+void rebuildYExtrema(CurveData& data) {
+    auto& extrema = data.y_extrema;
+    extrema.clear();
+    std::vector<float> decoded;
+    for (size_t i = 0; i < data.cold_blocks.size(); ++i) {
+        data.cold_blocks[i]->decode(decoded);
+        for (size_t j = i ? 0 : data.cold_offset; j < decoded.size(); ++j) {
+            extrema.push(decoded[j]);
+        }
+    }
+    for (auto point : data.points) {
+        extrema.push(point.second);
+    }
+    for (auto value : data.values) {
+        extrema.push(value);
+    }
+}
+
+// Start maintaining the statistics of a curve. The y extrema are shared with
+// the automatic y range
+void trackStatistics(CurveData& data) {
+    if (not data.tracksYExtrema()) {
+        rebuildYExtrema(data);
+    }
+    data.track_statistics = true;
+    rebuildStatistics(data);
+}
+
+// Give a new identifier to the content of a curve. Unique among all the
+// curves, so that a cached state never mistakes a cleared or replaced curve
+// for the one it was built from
+uint64_t newGeneration() {
+    static std::atomic<uint64_t> generation{0};
+    return ++generation;
+}
+
+// Remove all the samples of a curve
+void clearSamples(CurveData& data) {
+    data.generation = newGeneration();
+    data.points.clear();
+    data.values.clear();
+    data.cold_blocks.clear();
+    data.cold_size = 0;
+    data.cold_offset = 0;
+    data.x_extrema.clear();
+    data.y_extrema.clear();
+    data.statistics.clear();
+    data.front_block.reset();
+    data.first_sample = 0;
+    data.x_increasing = true;
+    if (data.trigger) {
+        data.trigger->reset();
+    }
+    data.age_marks.clear();
+}
+
+// Remove all the samples of a uniformly sampled curve and compute the x
+// coordinates of the next stored ones from the input sampling and the filter
+void resetUniformSampling(CurveData& data) {
+    clearSamples(data);
+    data.x0 = float(data.input_x0 + (double(data.input_samples) +
+                                     data.filter.outputOffset()) *
+                                        data.input_dx);
+    data.dx = data.input_dx * data.filter.outputStep();
+}
+
+// Number of samples per compressed block
+constexpr size_t compressed_block_size = 512;
+
+// Number of samples between two age marks, see CurveData::age_marks
+constexpr uint64_t age_mark_interval = 512;
+
+// Record when the last stored sample of a curve has been added, if it starts
+// a new group of samples. The marks not needed anymore are dropped here so
+// that they don't accumulate between two checks of the memory budget
+void markAge(CurveData& data) {
+    uint64_t sample = data.first_sample + data.size() - 1;
+    if (sample % age_mark_interval == 0) {
+        auto& marks = data.age_marks;
+        while (marks.size() > 1 and marks[1].first <= data.first_sample) {
+            marks.pop_front();
+        }
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        marks.push_back(std::make_pair(sample, uint64_t(now.count())));
+    }
+}
+
+// Steady clock time at which the oldest sample of a non empty curve has been
+// added
+uint64_t oldestSampleAge(CurveData& data) {
+    auto& marks = data.age_marks;
+    while (marks.size() > 1 and marks[1].first <= data.first_sample) {
+        marks.pop_front();
+    }
+    return marks.empty() ? 0 : marks.front().second;
+}
+
+// Move the oldest raw samples of a curve to a new compressed block
+void compressOldestSamples(CurveData& data) {
+    if (data.is_uniform) {
+        auto& values = data.compression_values;
+        values.clear();
+        for (size_t i = 0; i < compressed_block_size; ++i) {
+            values.push_back(data.values.front());
+            data.values.pop_front();
+        }
+        data.cold_blocks.push_back(std::make_shared<CompressedBlock>(values));
+    } else {
+        auto& points = data.compression_points;
+        points.clear();
+        for (size_t i = 0; i < compressed_block_size; ++i) {
+            points.push_back(data.points.front());
+            data.points.pop_front();
+        }
+        data.cold_blocks.push_back(std::make_shared<CompressedBlock>(points));
+    }
+    data.cold_size += compressed_block_size;
+}
+
+// Remove the oldest compressed sample of a curve
+void popCompressedSample(CurveData& data) {
+    assert(data.cold_size > 0);
+    --data.cold_size;
+    if (++data.cold_offset == data.cold_blocks.front()->size()) {
+        data.cold_blocks.pop_front();
+        data.cold_offset = 0;
+        data.front_block.reset();
+    }
+}
+
+// y value of the oldest sample of a curve, which must not be empty. The first
+// compressed block is decoded only once for all its samples
+float frontY(CurveData& data) {
+    if (data.cold_size > 0) {
+        const auto& block = data.cold_blocks.front();
+        if (data.front_block != block) {
+            block->decode(data.front_block_ys);
+            data.front_block = block;
+        }
+        return data.front_block_ys[data.cold_offset];
+    } else if (data.is_uniform or data.series) {
+        return data.values.front();
+    } else {
+        return data.points.front().second;
+    }
+}
+
+// Range containing no value
+std::pair<float, float> emptyRange() {
+    const float inf = std::numeric_limits<float>::infinity();
+    return std::make_pair(inf, -inf);
+}
+
+// x coordinate of a sample of a uniformly sampled snapshot
+float uniformX(const CurveSnapshot& data, size_t idx) {
+    return float(data.x0 + double(idx) * data.dx);
+}
+
+// Random access to the samples of a snapshot, the compressed ones being
+// decoded a block at a time
+class SampleReader {
+public:
+    using PointXY = std::pair<float, float>;
+
+    explicit SampleReader(const CurveSnapshot& data)
+        : data_(data), block_(nullptr) {
+    }
+
+    PointXY operator[](size_t idx) {
+        if (idx < data_.cold_size) {
+            // All the blocks hold compressed_block_size samples
+            size_t position = idx + data_.cold_offset;
+            const auto& block =
+                *data_.cold_blocks[position / compressed_block_size];
+            if (&block != block_) {
+                if (data_.is_uniform) {
+                    block.decode(decoded_ys_);
+                } else {
+                    block.decode(decoded_points_);
+                }
+                block_ = &block;
+            }
+            position %= compressed_block_size;
+            return data_.is_uniform
+                       ? PointXY(uniformX(data_, idx), decoded_ys_[position])
+                       : decoded_points_[position];
+        }
+        size_t raw = idx - data_.cold_size;
+        if (data_.is_uniform) {
+            return PointXY(uniformX(data_, idx), data_.values[raw]);
+        } else if (data_.is_series) {
+            return PointXY(data_.xs[raw], data_.values[raw]);
+        } else {
+            return data_.points[raw];
+        }
+    }
+
+private:
+    const CurveSnapshot& data_;
+    const CompressedBlock* block_;
+    std::vector<float> decoded_ys_;
+    std::vector<PointXY> decoded_points_;
+};
+
+// Index of the first sample of a snapshot, not uniformly sampled and whose x
+// coordinates are increasing, for which below(x) is false. Among the
+// compressed samples, only the block containing it, found from the blocks'
+// bounds, is decoded
+template <typename Below>
+size_t partitionSamples(const CurveSnapshot& data, SampleReader& samples,
+                        Below below) {
+    size_t first = 0;
+    size_t last = data.size();
+    const auto& blocks = data.cold_blocks;
+    if (not blocks.empty()) {
+        auto block = std::partition_point(
+            blocks.begin(), blocks.end(),
+            [&below](const std::shared_ptr<const CompressedBlock>& cold) {
+                return below(cold->xMax());
+            });
+        size_t idx = size_t(block - blocks.begin());
+        first = idx ? idx * compressed_block_size - data.cold_offset : 0;
+        if (block != blocks.end()) {
+            last = first + (*block)->size() - (idx ? 0 : data.cold_offset);
+        }
+    }
+    while (first < last) {
+        size_t middle = first + (last - first) / 2;
+        if (below(samples[middle].first)) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+// Index the samples of a snapshot in a new grid. The cells are sized to hold
+// about sixteen samples each on average
+std::unique_ptr<PointGrid> makeGrid(const CurveSnapshot& data) {
+    size_t count = data.size();
+    SampleReader samples(data);
+    auto bounds = std::make_pair(emptyRange(), emptyRange());
+    for (size_t i = 0; i < count; ++i) {
+        auto point = samples[i];
+        if (std::isfinite(point.first) and std::isfinite(point.second)) {
+            bounds.first.first = std::min(bounds.first.first, point.first);
+            bounds.first.second = std::max(bounds.first.second, point.first);
+            bounds.second.first = std::min(bounds.second.first, point.second);
+            bounds.second.second =
+                std::max(bounds.second.second, point.second);
+        }
+    }
+    float cells = std::max(std::sqrt(float(count) / 16.f), 1.f);
+    auto cellSize = [cells](const std::pair<float, float>& range) {
+        float size = (range.second - range.first) / cells;
+        return std::isnormal(size) ? size : 1.f;
+    };
+    auto grid = std::make_unique<PointGrid>(
+        std::make_pair(cellSize(bounds.first), cellSize(bounds.second)),
+        count);
+    for (size_t i = 0; i < count; ++i) {
+        grid->insert(data.first_sample + i, samples[i]);
+    }
+    return grid;
+}
+
+// Find the sample of a snapshot closest to a position, the x and y distances
+// being multiplied by scale. Only the x distance is used if the curve's x
+// coordinates are increasing, otherwise the samples are looked up in grid
+bool nearestSample(const CurveSnapshot& data, const PointGrid* grid,
+                   const std::pair<float, float>& position,
+                   const std::pair<float, float>& scale, float max_distance,
+                   std::pair<float, float>& point) {
+    size_t count = data.size();
+    if (count == 0) {
+        return false;
+    }
+    if (not data.x_increasing) {
+        return grid->nearest(position, scale, data.first_sample, max_distance,
+                             point);
+    }
+
+    SampleReader samples(data);
+    size_t idx;
+    if (data.is_uniform) {
+        double offset = std::round((position.first - data.x0) / data.dx);
+        idx = size_t(std::min(std::max(offset, 0.), double(count - 1)));
+    } else {
+        // First sample at or after the position, or its predecessor if it is
+        // closer
+        idx = std::min(partitionSamples(data, samples,
+                                        [&position](float x) {
+                                            return x < position.first;
+                                        }),
+                       count - 1);
+        if (idx > 0 and position.first - samples[idx - 1].first <
+                            samples[idx].first - position.first) {
+            --idx;
+        }
+    }
+    point = samples[idx];
+    return std::abs((point.first - position.first) * scale.first) <=
+           max_distance;
+}
+
+// Smallest value of the form 1, 2 or 5 times a power of ten greater than or
+// equal to a strictly positive value
+double roundStep(double value) {
+    double magnitude = std::pow(10., std::floor(std::log10(value)));
+    for (double factor : {1., 2., 5.}) {
+        if (factor * magnitude >= value) {
+            return factor * magnitude;
+        }
+    }
+    return 10. * magnitude;
+}
+
+// Smallest range containing the given one and made of subdivisions intervals
+// of a round size, so that the ticks fall on round values
+std::pair<float, float> roundRange(std::pair<float, float> range,
+                                   int subdivisions) {
+    double span = double(range.second) - double(range.first);
+    if (not std::isfinite(span)) {
+        return range;
+    }
+    if (span == 0.) {
+        float margin = std::max(std::abs(range.first), 1.f) / 2.f;
+        range.first -= margin;
+        range.second += margin;
+        span = 2. * margin;
+    }
+    double step = roundStep(span / subdivisions);
+    for (;;) {
+        double lower = std::floor(range.first / step) * step;
+        double upper = lower + subdivisions * step;
+        if (upper >= range.second) {
+            return std::make_pair(float(lower), float(upper));
+        }
+        step = roundStep(step * 1.5);
+    }
+}
+
+// Automatic range for the given data bounds. The previous range is kept as
+// long as it contains the data and isn't more than twice larger than needed,
+// so that the transform to screen coordinates rarely changes
+std::pair<float, float> autoRange(const std::pair<float, float>& data_range,
+                                  std::pair<float, float>& previous,
+                                  int subdivisions) {
+    // No data
+    if (not(data_range.first <= data_range.second)) {
+        return data_range;
+    }
+    auto range = roundRange(data_range, subdivisions);
+    bool fits = previous.first <= data_range.first and
+                data_range.second <= previous.second and
+                previous.second - previous.first <=
+                    2.f * (range.second - range.first);
+    if (not fits) {
+        previous = range;
+    }
+    return previous;
+}
+
+// Remove the per curve state of the curves not drawn anymore
+template <typename T>
+void releaseHiddenCurves(std::map<int, T>& states,
+                         const std::vector<CurveSnapshot>& curves) {
+    for (auto it = states.begin(); it != states.end();) {
+        auto drawn = std::find_if(curves.begin(), curves.end(),
+                                  [&it](const CurveSnapshot& data) {
+                                      return data.curve == it->first and
+                                             data.is_visible;
+                                  });
+        if (drawn == curves.end()) {
+            it = states.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Decimate the points of a curve to at most one per pixel column
+class Decimator {
+public:
+    Decimator(bool enabled, float step)
+        : enabled_(enabled), step_(step), x_(0.f), prev_x_(0), first_(true) {
+    }
+
+    // Return true if the next point must be drawn
+    bool keep() {
+        if (first_) {
+            first_ = false;
+            return true;
+        }
+        if (not enabled_) {
+            return true;
+        }
+        x_ += step_;
+        if (int(x_) > prev_x_) {
+            prev_x_ = int(x_);
+            return true;
+        }
+        return false;
+    }
+
+    // Account for points drawn without going through keep()
+    void skip(size_t count) {
+        first_ = false;
+        x_ += step_ * count;
+        prev_x_ = int(x_);
+    }
+
+private:
+    bool enabled_;
+    float step_;
+    float x_;
+    int prev_x_;
+    bool first_;
+};
+
+// Memory used by the nodes of the ordered associative containers, which hold
+// the color and three pointers in addition to the element
+template <typename Container> size_t treeNodesMemory(const Container& tree) {
+    return tree.size() *
+           (sizeof(typename Container::value_type) + 4 * sizeof(void*));
+}
+
+// Memory used by a curve. The x coordinates of a frame series' channels are
+// accounted for by the series. Its lock must be held by the caller
+MemoryUsage curveMemory(const CurveData& data) {
+    MemoryUsage usage;
+    usage.samples = data.points.memoryUsage() + data.values.memoryUsage();
+    usage.compressed =
+        std::accumulate(data.cold_blocks.begin(), data.cold_blocks.end(),
+                        size_t(0),
+                        [](size_t bytes, const auto& block) {
+                            return bytes + block->memoryUsage();
+                        }) +
+        data.cold_blocks.size() * sizeof(data.cold_blocks.front()) +
+        data.front_block_ys.capacity() * sizeof(float) +
+        data.compression_points.capacity() * sizeof(CurveData::PointXY) +
+        data.compression_values.capacity() * sizeof(float);
+    usage.indexes = data.x_extrema.memoryUsage() +
+                    data.y_extrema.memoryUsage() +
+                    data.age_marks.capacity() * sizeof(data.age_marks[0]);
+    if (data.trigger) {
+        usage.indexes += sizeof(TriggerCapture) + data.trigger->memoryUsage();
+    }
+    usage.other = sizeof(CurveData) + data.label.capacity() +
+                  data.plots.capacity() * sizeof(RTPlotCore*);
+    return usage;
+}
+
+// Tell if the oldest samples of a curve are still referenced by a snapshot,
+// e.g the one of a frozen plot, so that removing them wouldn't free anything.
+// Its lock must be held by the caller
+bool oldestSamplesShared(const CurveData& data) {
+    if (auto series = data.series.load(std::memory_order_relaxed)) {
+        return series->x.frontShared() or
+               std::any_of(series->channels.begin(), series->channels.end(),
+                           [](const CurveData* channel) {
+                               return channel->values.frontShared();
+                           });
+    }
+    if (data.cold_size > 0) {
+        const auto& block = data.cold_blocks.front();
+        return block.use_count() > (data.front_block == block ? 2 : 1);
+    }
+    return data.points.frontShared() or data.values.frontShared();
+}
+
+// Tell if a curve doesn't use more than the storage set aside by
+// RTPlotCore::reserve(). Evicting its samples would only move their segments
+// to its pool. The curve's lock must be held
+bool withinReserve(const CurveData& data) {
+    if (auto series = data.series.load(std::memory_order_relaxed)) {
+        return series->x.withinReserve() and
+               std::all_of(series->channels.begin(), series->channels.end(),
+                           [](const CurveData* channel) {
+                               return channel->values.withinReserve();
+                           });
+    }
+    if (data.cold_size > 0) {
+        return false;
+    }
+    return data.is_uniform ? data.values.withinReserve()
+                           : data.points.withinReserve();
+}
+
+// Memory used by a frame series, its channels excluded. Its lock must be held
+// by the caller
+MemoryUsage seriesMemory(const FrameSeries& series) {
+    MemoryUsage usage;
+    usage.samples = series.x.memoryUsage();
+    usage.indexes = series.x_extrema.memoryUsage();
+    usage.other = sizeof(FrameSeries) +
+                  series.channels.capacity() * sizeof(CurveData*);
+    return usage;
+}
+
+// Memory used by a snapshot, the curve's storage excluded
+size_t snapshotMemory(const CurveSnapshot& snapshot) {
+    return snapshot.points.memoryUsage() + snapshot.values.memoryUsage() +
+           snapshot.xs.memoryUsage() +
+           snapshot.cold_blocks.capacity() *
+               sizeof(std::shared_ptr<const CompressedBlock>) +
+           snapshot.sweeps.capacity() *
+               sizeof(std::shared_ptr<const TriggerSweep>) +
+           snapshot.label.capacity();
+}
+
+// Plots sharing the memory budget
+struct PlotRegistry {
+    std::mutex lock;
+    std::vector<RTPlotCore*> plots;
+    std::chrono::steady_clock::time_point last_budget_check;
+};
+
+PlotRegistry& plotRegistry() {
+    static PlotRegistry registry;
+    return registry;
+}
+
+// Maximum number of bytes used by all the plots, zero if unlimited
+std::atomic<size_t> memory_budget(0);
+
+} // namespace
+
 RTPlotCore::RTPlotCore() {
     palette_ = {Colors::Red,      Colors::Green,       Colors::Yellow,
                 Colors::Blue,     Colors::Magenta,     Colors::Cyan,
@@ -55,123 +794,839 @@ RTPlotCore::RTPlotCore() {
 
     auto_xrange_ = false;
     auto_yrange_ = false;
+    nice_xrange_ = emptyRange();
+    nice_yrange_ = emptyRange();
+    // Set by the first frame
+    current_xscale_ = 0.f;
+    current_yscale_ = 0.f;
 
     display_cursor_coordinates_ = false;
     fast_plotting_ = false;
+    statistics_ = false;
+    display_statistics_ = false;
+    label_area_outdated_ = false;
+    density_plotting_ = false;
+    persistence_ = 1.f;
+    images_unsupported_ = false;
+    frozen_ = false;
+    dragging_ = false;
 
     display_labels_btn_text_ = "+";
+
+    frames_ = 0;
+    last_metrics_poll_ = std::chrono::steady_clock::now();
+    last_metrics_points_ = 0;
+    prepare_duration_ = std::chrono::steady_clock::duration::zero();
+
+#ifdef RTPLOT_FRAME_PROFILER
+    profiler_ = std::make_unique<FrameProfiler>();
+#endif
+
+    shards_.reset(new CurveShard[curve_shards]);
+    render_ = std::make_unique<RenderState>();
+    render_->cursor_lookups = false;
+    frame_series_ptr_ = nullptr;
+    widget_ = WidgetGeometry{0, 0, 0, 0};
+    frame_outdated_ = true;
+
+    frame_budget_ms_ = 0.f;
+    quality_ = QualityLevel::Full;
+    average_draw_time_ms_ = 0.f;
+    frames_since_quality_change_ = 0;
+    frames_under_budget_ = 0;
+
+    auto& registry = plotRegistry();
+    std::lock_guard<std::mutex> registry_lock(registry.lock);
+    registry.plots.push_back(this);
+}
+
+RTPlotCore::~RTPlotCore() {
+    {
+        // Waits for the memory budget check using this plot, if any
+        auto& registry = plotRegistry();
+        std::lock_guard<std::mutex> registry_lock(registry.lock);
+        auto& plots = registry.plots;
+        plots.erase(std::remove(plots.begin(), plots.end(), this),
+                    plots.end());
+    }
+    // Shared curves can outlive the plot
+    for (auto curves : {&curves_, &detached_curves_}) {
+        for (auto& data : *curves) {
+            auto lock = lockCurve(*data);
+            auto& plots = data->plots;
+            plots.erase(std::remove(plots.begin(), plots.end(), this),
+                        plots.end());
+        }
+    }
+}
+
+void RTPlotCore::invalidate() {
+    // Only write when needed so that the producers don't keep stealing the
+    // cache line from each other
+    if (not frame_outdated_.load(std::memory_order_relaxed)) {
+        frame_outdated_.store(true, std::memory_order_relaxed);
+    }
+}
+
+RTPlotCore::CurveShard& RTPlotCore::shardOf(int curve) const {
+    return shards_[static_cast<unsigned>(curve) % curve_shards];
+}
+
+CurveData* RTPlotCore::lookupCurve(int curve) const {
+    auto& shard = shardOf(curve);
+    std::lock_guard<std::mutex> shard_lock(shard.lock);
+    auto it = std::lower_bound(
+        shard.curves.begin(), shard.curves.end(), curve,
+        [](const CurveData* data, int id) { return data->id < id; });
+    if (it != shard.curves.end() and (*it)->id == curve) {
+        return *it;
+    }
+    return nullptr;
+}
+
+CurveData& RTPlotCore::getCurveConcurrently(int curve) {
+    auto data = lookupCurve(curve);
+    if (data == nullptr) {
+        std::lock_guard<std::mutex> curves_lock(curves_lock_);
+        data = &getCurve(curve);
+    }
+    return *data;
+}
+
+size_t RTPlotCore::curvePosition(int curve) const {
+    auto it = std::lower_bound(curves_.begin(), curves_.end(), curve,
+                               [](const std::shared_ptr<CurveData>& data,
+                                  int id) { return data->id < id; });
+    return size_t(it - curves_.begin());
+}
+
+CurveData* RTPlotCore::findCurve(int curve) const {
+    auto idx = curvePosition(curve);
+    if (idx < curves_.size() and curves_[idx]->id == curve) {
+        return curves_[idx].get();
+    }
+    return nullptr;
+}
+
+CurveData& RTPlotCore::getCurve(int curve) {
+    auto data = findCurve(curve);
+    if (data == nullptr) {
+        // Not created with make_shared, it would ignore CurveData's alignment
+        std::shared_ptr<CurveData> new_data(new CurveData(curve));
+        new_data->generation = newGeneration();
+        new_data->plots.push_back(this);
+        new_data->track_x_extrema = auto_xrange_;
+        new_data->track_y_extrema = auto_yrange_;
+        new_data->track_statistics = statistics_;
+        data = new_data.get();
+        registerCurve(std::move(new_data));
+    }
+    return *data;
+}
+
+void RTPlotCore::registerCurve(std::shared_ptr<CurveData> data) {
+    int curve = data->id;
+    auto& shard = shardOf(curve);
+    std::lock_guard<std::mutex> shard_lock(shard.lock);
+    auto pos = std::lower_bound(
+        shard.curves.begin(), shard.curves.end(), curve,
+        [](const CurveData* data, int id) { return data->id < id; });
+    auto idx = curvePosition(curve);
+    if (idx < curves_.size() and curves_[idx]->id == curve) {
+        // The replaced curve is kept alive for its CurveHandles
+        *pos = data.get();
+        detached_curves_.push_back(std::move(curves_[idx]));
+        curves_[idx] = std::move(data);
+    } else {
+        shard.curves.insert(pos, data.get());
+        curves_.insert(curves_.begin() + idx, std::move(data));
+    }
+}
+
+void RTPlotCore::attachCurve(RTPlotCore& source, int curve) {
+    if (&source == this) {
+        return;
+    }
+
+    std::shared_ptr<CurveData> data;
+    {
+        std::lock_guard<std::mutex> curves_lock(source.curves_lock_);
+        source.getCurve(curve);
+        data = source.curves_[source.curvePosition(curve)];
+    }
+    if (data->series) {
+        std::cerr << "Curve " << curve
+                  << " is part of a frame series, it can't be shared\n";
+        return;
+    }
+
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto previous = findCurve(curve);
+    if (previous == data.get()) {
+        return;
+    }
+    derived_curves_.erase(curve);
+    {
+        auto lock = lockCurve(*data);
+        data->plots.push_back(this);
+        if (auto_xrange_ and not data->track_x_extrema) {
+            data->track_x_extrema = true;
+            rebuildXExtrema(*data);
+        }
+        if (auto_yrange_ and not data->track_y_extrema) {
+            data->track_y_extrema = true;
+            rebuildYExtrema(*data);
+        }
+        if (statistics_ and not data->track_statistics) {
+            trackStatistics(*data);
+        }
+    }
+    if (previous) {
+        auto lock = lockCurve(*previous);
+        auto& plots = previous->plots;
+        plots.erase(std::remove(plots.begin(), plots.end(), this),
+                    plots.end());
+    }
+    registerCurve(std::move(data));
+    invalidate();
+}
+
+void RTPlotCore::invalidatePlots(const CurveData& data) {
+    for (auto plot : data.plots) {
+        plot->invalidateData();
+    }
+}
+
+void RTPlotCore::invalidateData() {
+    if (not frozen_.load(std::memory_order_relaxed)) {
+        invalidate();
+    }
 }
 
-RTPlotCore::~RTPlotCore() = default;
+CurveHandle RTPlotCore::getCurveHandle(int curve) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    return CurveHandle(this, &getCurve(curve));
+}
 
 void RTPlotCore::addPoint(int curve, float x, float y) {
-    auto& data = curves_data_[curve];
+    addPoints(curve, &x, &y, 1);
+}
+
+void RTPlotCore::addPoints(int curve, const float* xs, const float* ys,
+                           size_t count) {
+    auto data = &getCurveConcurrently(curve);
+    if (not addPoints(*data, xs, ys, count)) {
+        std::cerr << "Curve " << curve
+                  << (data->series ? " is part of a frame series, use "
+                                     "addFrame instead\n"
+                                   : " is uniformly sampled, use addSample "
+                                     "instead\n");
+    }
+}
+
+bool RTPlotCore::addPoint(CurveData& data, float x, float y) {
+    return addPoints(data, &x, &y, 1);
+}
+
+bool RTPlotCore::addPoints(CurveData& data, const float* xs, const float* ys,
+                           size_t count) {
+    auto lock = lockCurve(data, lock_wait_);
+
+    if (data.is_uniform or data.series) {
+        return false;
+    }
 
-    if (data.points.size() == data.max_points) {
-        removeFirstPoint(curve);
+    auto store = [this, &data](float x, float y) { storePoint(data, x, y); };
+    for (size_t i = 0; i < count; ++i) {
+        data.filter.process(xs[i], ys[i], store);
     }
+    data.points_added += count;
+    invalidatePlots(data);
+    return true;
+}
 
-    std::lock_guard<std::mutex> lock(data.lock_);
+void RTPlotCore::storePoint(CurveData& data, float x, float y) {
+    while (data.size() > 0 and data.size() >= data.max_points) {
+        popFront(data);
+        ++data.points_evicted;
+    }
 
+    if (not data.points.empty() and x < data.points.back().first) {
+        data.x_increasing = false;
+    }
     data.points.push_back(std::make_pair(x, y));
+    if (data.trigger) {
+        data.trigger->process(x, y);
+    }
+    markAge(data);
 
-    if (auto_xrange_) {
-        data.previous_insertion_point.first = data.ordered_list.first.insert(
-            data.previous_insertion_point.first, x);
-        float min_val = std::numeric_limits<float>::infinity();
-        float max_val = -std::numeric_limits<float>::infinity();
-        for (auto& curve_data : curves_data_) {
-            auto& list = curve_data.second.ordered_list.first; // xvalues
-            if (list.empty() or not curve_data.second.is_visible) {
-                continue;
-            }
-            float c_min = *list.begin();
-            float c_max = *(--list.end());
-            min_val = std::min(min_val, c_min);
-            max_val = std::max(max_val, c_max);
-        }
-        xrange_auto_.first = min_val;
-        xrange_auto_.second = max_val;
-    }
-    if (auto_yrange_) {
-        data.previous_insertion_point.second = data.ordered_list.second.insert(
-            data.previous_insertion_point.second, y);
-        float min_val = std::numeric_limits<float>::infinity();
-        float max_val = -std::numeric_limits<float>::infinity();
-        for (auto& curve_data : curves_data_) {
-            auto& list = curve_data.second.ordered_list.second; // yvalues
-            if (list.empty() or not curve_data.second.is_visible) {
-                continue;
-            }
-            float c_min = *list.begin();
-            float c_max = *(--list.end());
-            min_val = std::min(min_val, c_min);
-            max_val = std::max(max_val, c_max);
+    if (data.raw_samples and
+        data.points.size() >= data.raw_samples + compressed_block_size) {
+        compressOldestSamples(data);
+    }
+
+    if (data.track_x_extrema) {
+        data.x_extrema.push(x);
+    }
+    if (data.tracksYExtrema()) {
+        data.y_extrema.push(y);
+    }
+    if (data.track_statistics) {
+        data.statistics.push(y);
+    }
+}
+
+void RTPlotCore::addSample(int curve, float y) {
+    addSamples(curve, &y, 1);
+}
+
+void RTPlotCore::addSamples(int curve, const float* ys, size_t count) {
+    auto data = &getCurveConcurrently(curve);
+    if (not addSamples(*data, ys, count)) {
+        std::cerr << "Curve " << curve
+                  << (data->series ? " is part of a frame series, use "
+                                     "addFrame instead\n"
+                                   : " is not uniformly sampled, use addPoint "
+                                     "instead\n");
+    }
+}
+
+bool RTPlotCore::addSample(CurveData& data, float y) {
+    return addSamples(data, &y, 1);
+}
+
+bool RTPlotCore::addSamples(CurveData& data, const float* ys, size_t count) {
+    auto lock = lockCurve(data, lock_wait_);
+
+    if (not data.is_uniform or data.series) {
+        return false;
+    }
+
+    // The x coordinates of the stored samples are deduced from their index
+    auto store = [this, &data](float, float y) { storeSample(data, y); };
+    for (size_t i = 0; i < count; ++i) {
+        data.filter.process(0.f, ys[i], store);
+    }
+    data.input_samples += count;
+    data.points_added += count;
+    invalidatePlots(data);
+    return true;
+}
+
+void RTPlotCore::storeSample(CurveData& data, float y) {
+    while (data.size() > 0 and data.size() >= data.max_points) {
+        popFront(data);
+        ++data.points_evicted;
+    }
+
+    data.values.push_back(y);
+    if (data.trigger) {
+        data.trigger->process(data.sampleX(data.size() - 1), y);
+    }
+    markAge(data);
+
+    if (data.raw_samples and
+        data.values.size() >= data.raw_samples + compressed_block_size) {
+        compressOldestSamples(data);
+    }
+
+    if (data.tracksYExtrema()) {
+        data.y_extrema.push(y);
+    }
+    if (data.track_statistics) {
+        data.statistics.push(y);
+    }
+}
+
+void RTPlotCore::setUniformSampling(int curve, float x0, float dx) {
+    assert(dx > 0.f);
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto& data = getCurve(curve);
+    if (data.series) {
+        std::cerr << "Curve " << curve
+                  << " is part of a frame series, it can't be uniformly "
+                     "sampled\n";
+        return;
+    }
+    auto lock = lockCurve(data);
+    data.is_uniform = true;
+    data.input_x0 = x0;
+    data.input_dx = dx;
+    data.input_samples = 0;
+    data.filter.reset();
+    resetUniformSampling(data);
+    invalidatePlots(data);
+}
+
+void RTPlotCore::setIngestionFilter(int curve, IngestionFilter filter,
+                                    size_t factor) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto& data = getCurve(curve);
+    if (data.series) {
+        std::cerr << "Curve " << curve
+                  << " is part of a frame series, it can't be filtered\n";
+        return;
+    }
+    auto lock = lockCurve(data);
+    data.filter.configure(filter, factor);
+    if (data.is_uniform) {
+        resetUniformSampling(data);
+    }
+    invalidatePlots(data);
+}
+
+void RTPlotCore::setTrigger(int curve, TriggerMode mode, float level,
+                            size_t pre_samples, size_t post_samples,
+                            size_t sweeps) {
+    assert(sweeps > 0);
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto& data = getCurve(curve);
+    // Allocated before taking the curve's lock to not block the producers
+    auto trigger = std::make_unique<TriggerCapture>(mode, level, pre_samples,
+                                                    post_samples, sweeps);
+    auto lock = lockCurve(data);
+    std::swap(data.trigger, trigger);
+    invalidatePlots(data);
+}
+
+void RTPlotCore::removeTrigger(int curve) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto& data = getCurve(curve);
+    std::unique_ptr<TriggerCapture> trigger;
+    auto lock = lockCurve(data);
+    std::swap(data.trigger, trigger);
+    invalidatePlots(data);
+}
+
+uint64_t RTPlotCore::getCaptureCount(int curve) const {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto data = findCurve(curve);
+    if (data == nullptr) {
+        throw std::out_of_range("Curve " + std::to_string(curve) +
+                                " doesn't exist");
+    }
+    auto lock = lockCurve(*data);
+    return data->trigger ? data->trigger->captures() : 0;
+}
+
+void RTPlotCore::setDifferenceCurve(int curve, int lhs, int rhs) {
+    setDerivedCurve(curve, std::make_unique<DifferenceCurve>(lhs, rhs));
+}
+
+void RTPlotCore::setScaledCurve(int curve, int source, float gain,
+                                float offset) {
+    setDerivedCurve(curve,
+                    std::make_unique<ScaledCurve>(source, gain, offset));
+}
+
+void RTPlotCore::setMovingAverageCurve(int curve, int source, size_t window) {
+    setDerivedCurve(curve,
+                    std::make_unique<MovingAverageCurve>(source, window));
+}
+
+void RTPlotCore::setSpectrumCurve(int curve, int source, size_t samples) {
+    setDerivedCurve(curve, std::make_unique<SpectrumCurve>(source, samples));
+}
+
+void RTPlotCore::removeDerivedCurve(int curve) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    derived_curves_.erase(curve);
+}
+
+void RTPlotCore::setDerivedCurve(int curve,
+                                 std::unique_ptr<DerivedCurve> derived) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    const auto& sources = derived->sources();
+    for (int source : sources) {
+        if (source == curve) {
+            std::cerr << "Curve " << curve
+                      << " can't be derived from itself\n";
+            return;
+        }
+        if (derived_curves_.count(source)) {
+            std::cerr << "Curve " << source
+                      << " is a derived curve, it can't be used as a source\n";
+            return;
+        }
+    }
+    for (const auto& other : derived_curves_) {
+        const auto& other_sources = other.second->sources();
+        if (std::find(other_sources.begin(), other_sources.end(), curve) !=
+            other_sources.end()) {
+            std::cerr << "Curve " << curve
+                      << " is the source of a derived curve, it can't be "
+                         "derived itself\n";
+            return;
+        }
+    }
+    for (int source : sources) {
+        getCurve(source);
+    }
+    auto& data = getCurve(curve);
+    if (data.series) {
+        std::cerr << "Curve " << curve
+                  << " is part of a frame series, it can't be derived\n";
+        return;
+    }
+    {
+        auto lock = lockCurve(data);
+        data.is_uniform = false;
+        clearSamples(data);
+        invalidatePlots(data);
+    }
+    derived_curves_[curve] = std::move(derived);
+}
+
+void RTPlotCore::addFrame(float x, const float* ys, size_t count) {
+    auto series = frame_series_ptr_.load(std::memory_order_acquire);
+    if (series == nullptr) {
+        std::lock_guard<std::mutex> curves_lock(curves_lock_);
+        series = &getFrameSeries(count);
+    }
+    if (not addFrame(*series, x, ys, count)) {
+        std::cerr << "The frame series has " << series->channels.size()
+                  << " channels, can't add a frame of " << count
+                  << " values\n";
+    }
+}
+
+FrameSeries& RTPlotCore::getFrameSeries(size_t channels) {
+    assert(channels > 0);
+    if (not frame_series_) {
+        auto series = std::make_unique<FrameSeries>();
+        for (size_t i = 0; i < channels; ++i) {
+            auto& data = getCurve(int(i));
+            auto lock = lockCurve(data);
+            clearSamples(data);
+            data.is_uniform = false;
+            data.raw_samples = 0;
+            series->channels.push_back(&data);
+            // From now on the curve is protected by the series' lock
+            data.series.store(series.get(), std::memory_order_release);
+        }
+        series->max_points = series->channels.front()->max_points;
+        frame_series_ = std::move(series);
+        frame_series_ptr_.store(frame_series_.get(),
+                                std::memory_order_release);
+    }
+    return *frame_series_;
+}
+
+bool RTPlotCore::addFrame(FrameSeries& series, float x, const float* ys,
+                          size_t count) {
+    auto lock = lockCurve(series.lock_, lock_wait_);
+
+    if (count != series.channels.size()) {
+        return false;
+    }
+
+    while (series.x.size() > 0 and series.x.size() >= series.max_points) {
+        popFrontFrame(series);
+        for (auto data : series.channels) {
+            ++data->points_evicted;
+        }
+    }
+
+    if (not series.x.empty() and x < series.x.back()) {
+        series.x_increasing = false;
+    }
+    series.x.push_back(x);
+    if (series.channels.front()->track_x_extrema) {
+        series.x_extrema.push(x);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        auto& data = *series.channels[i];
+        data.values.push_back(ys[i]);
+        ++data.points_added;
+        if (data.trigger) {
+            data.trigger->process(x, ys[i]);
+        }
+        markAge(data);
+        if (data.tracksYExtrema()) {
+            data.y_extrema.push(ys[i]);
         }
-        yrange_auto_.first = min_val;
-        yrange_auto_.second = max_val;
+        if (data.track_statistics) {
+            data.statistics.push(ys[i]);
+        }
+    }
+    invalidateData();
+    return true;
+}
+
+void RTPlotCore::popFrontFrame(FrameSeries& series) {
+    series.x.pop_front();
+    if (series.channels.front()->track_x_extrema) {
+        series.x_extrema.pop();
+    }
+    for (auto data : series.channels) {
+        if (data->track_statistics) {
+            data->statistics.pop(data->values.front());
+        }
+        data->values.pop_front();
+        ++data->first_sample;
+        if (data->tracksYExtrema()) {
+            data->y_extrema.pop();
+        }
+    }
+    if (series.x.empty()) {
+        series.x_increasing = true;
+    }
+}
+
+void RTPlotCore::enableCompression(int curve, size_t raw_samples) {
+    assert(raw_samples > 0);
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto& data = getCurve(curve);
+    auto lock = lockCurve(data);
+    data.raw_samples = raw_samples;
+}
+
+void RTPlotCore::disableCompression(int curve) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto& data = getCurve(curve);
+    auto lock = lockCurve(data);
+    data.raw_samples = 0;
+}
+
+void RTPlotCore::reserve(int curve, size_t count) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto& data = getCurve(curve);
+    auto lock = lockCurve(data);
+    auto series = data.series.load();
+    if (data.is_uniform or series) {
+        data.values.reserve(count);
+    } else {
+        data.points.reserve(count);
+        data.x_extrema.reserve(count);
+    }
+    data.y_extrema.reserve(count);
+    // One mark per age_mark_interval samples, plus the one preceding the
+    // oldest sample and the one being added
+    data.age_marks.reserve(count / age_mark_interval + 2);
+    if (series) {
+        series->x.reserve(count);
+        series->x_extrema.reserve(count);
     }
 }
 
 void RTPlotCore::removeFirstPoint(int curve) {
-    CurveData* data;
-    try {
-        data = &(curves_data_.at(curve));               // check for existance
-        if (data->points.begin() == data->points.end()) // check if non-empty
-            return;
-    } catch (const std::out_of_range& oor) {
+    auto data = lookupCurve(curve);
+    if (data == nullptr) {
         std::cerr << "Curve " << curve
                   << " doesn't exist, can't remove a point from it\n";
         return;
     }
+    removeFirstPoint(*data);
+}
 
-    std::lock_guard<std::mutex> lock(data->lock_);
+void RTPlotCore::removeFirstPoint(CurveData& data) {
+    auto lock = lockCurve(data, lock_wait_);
+
+    if (data.size() == 0) {
+        return;
+    }
 
-    auto& points = data->points;
-    auto& ordered_list = data->ordered_list;
+    // The samples of a series can only be removed a frame at a time
+    if (auto series = data.series.load()) {
+        popFrontFrame(*series);
+    } else {
+        popFront(data);
+    }
+    invalidatePlots(data);
+}
 
-    PointXY removed_point = points.front();
+void RTPlotCore::popFront(CurveData& data) {
+    if (data.track_statistics) {
+        data.statistics.pop(frontY(data));
+    }
+    if (data.cold_size > 0) {
+        popCompressedSample(data);
+    } else if (data.is_uniform) {
+        data.values.pop_front();
+    } else {
+        data.points.pop_front();
+    }
+    ++data.first_sample;
 
-    points.pop_front();
+    if (data.track_x_extrema and not data.is_uniform) {
+        data.x_extrema.pop();
+    }
+    if (data.tracksYExtrema()) {
+        data.y_extrema.pop();
+    }
+    if (data.size() == 0) {
+        data.x_increasing = true;
+    }
+}
 
-    if (auto_xrange_) {
-        auto& xlist = ordered_list.first;
-        auto it = xlist.find(removed_point.first);
-        if (it != xlist.end()) { // Shouldn't be necessary
-            xlist.erase(it);
+void RTPlotCore::exportData(std::ostream& out, ExportFormat format) {
+    std::vector<CurveSnapshot> curves;
+    {
+        std::lock_guard<std::mutex> curves_lock(curves_lock_);
+        curves.resize(curves_.size());
+        for (size_t i = 0; i < curves_.size(); ++i) {
+            auto& data = *curves_[i];
+            curves[i].is_visible = hidden_curves_.count(data.id) == 0;
+            auto lock = lockCurve(data, lock_wait_);
+            captureCurve(data, curves[i]);
         }
     }
 
-    if (auto_yrange_) {
-        auto& ylist = ordered_list.second;
-        auto it = ylist.find(removed_point.second);
-        if (it != ylist.end()) { // Shouldn't be necessary
-            ylist.erase(it);
-        }
+    switch (format) {
+    case ExportFormat::CSV:
+        exportCsv(out, curves);
+        break;
+    case ExportFormat::Binary:
+        exportBinary(out, curves);
+        break;
     }
 }
 
 void RTPlotCore::displayLabels() {
     if (not display_labels_) {
         display_labels_ = true;
+        invalidate();
         display_labels_btn_text_ = "-";
 
-        int max_text_width = 0;
-        for (auto& curve : curves_data_) {
-            auto& lbl = curve.second.label;
-            Pairf size = measureText(lbl);
-            max_text_width = std::max<int>(max_text_width, size.first);
-        }
-        label_area_width_ = max_text_width;
-        if (label_area_width_)
-            label_area_width_ += 40;
+        updateLabelAreaWidth();
 
         refresh();
     }
 }
+
+void RTPlotCore::updateLabelAreaWidth() {
+    int max_text_width = 0;
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    for (auto& curve : curves_) {
+        auto& lbl = curve->label;
+        Pairf size = measureText(lbl);
+        max_text_width = std::max<int>(max_text_width, size.first);
+    }
+    // Sized for values with a few digits, larger ones are clipped
+    if (display_statistics_ and not curves_.empty()) {
+        CurveStatistics sample;
+        sample.mean = sample.rms = sample.stddev = -8.88;
+        sample.min = sample.max = -8.88f;
+        Pairf size = measureText(statisticsText(sample));
+        max_text_width = std::max<int>(max_text_width, size.first);
+    }
+    label_area_width_ = max_text_width;
+    if (label_area_width_)
+        label_area_width_ += 40;
+}
+
+int RTPlotCore::labelRowHeight() const {
+    // The statistics take a second line
+    return display_statistics_ ? 32 : 16;
+}
+
+bool RTPlotCore::findNearestSample(CurveData& data, const PointXY& position,
+                                   float max_distance, PointXY& point) {
+    // The lookup works on a snapshot so that the producers are only blocked
+    // while it is taken, not while the grid is updated
+    auto& snapshot = render_->lookup;
+    {
+        auto lock = lockCurve(data, lock_wait_);
+        captureCurve(data, snapshot);
+    }
+    bool found = findNearestSample(snapshot, position, max_distance, point);
+    snapshot.clear();
+    return found;
+}
+
+bool RTPlotCore::findNearestSample(const CurveSnapshot& data,
+                                   const PointXY& position,
+                                   float max_distance, PointXY& point) {
+    if (data.size() == 0 or not std::isnormal(current_xscale_) or
+        not std::isnormal(current_yscale_)) {
+        return false;
+    }
+    render_->cursor_lookups = true;
+    const PointGrid* grid = nullptr;
+    if (not data.x_increasing) {
+        auto& cursor = render_->cursor_grids[data.curve];
+        if (not cursor.grid or cursor.generation != data.generation or
+            cursor.grid->outdated(data.size())) {
+            cursor.grid = makeGrid(data);
+            cursor.generation = data.generation;
+        } else {
+            // Only the samples added since the previous lookup are inserted
+            uint64_t sample = std::max(cursor.next_sample, data.first_sample);
+            auto& cursor_grid = *cursor.grid;
+            data.read(
+                [&cursor_grid, &sample](const PointXY* points, size_t count) {
+                    for (size_t i = 0; i < count; ++i) {
+                        cursor_grid.insert(sample++, points[i]);
+                    }
+                },
+                size_t(sample - data.first_sample));
+        }
+        cursor.next_sample = data.first_sample + data.size();
+        grid = cursor.grid.get();
+    }
+    return nearestSample(
+        data, grid, scaleToGraph(position),
+        PointXY(std::abs(current_xscale_), std::abs(current_yscale_)),
+        max_distance, point);
+}
+
+void RTPlotCore::drawCursorReadout() {
+    // Color index and text of each curve's readout
+    std::vector<std::pair<size_t, std::string>> readouts;
+    auto addReadout = [&readouts](size_t idx, int curve,
+                                  const std::string& label,
+                                  const PointXY& point) {
+        readouts.emplace_back(
+            idx, (label.empty() ? std::to_string(curve) : label) + ": " +
+                     std::to_string(point.first) + ", " +
+                     std::to_string(point.second));
+    };
+    PointXY point;
+    if (frozen_) {
+        // The displayed samples are the ones of the pinned snapshot
+        for (size_t i = 0; i < render_->frame_curves.size(); ++i) {
+            const auto& data = render_->frame_curves[i];
+            if (data.is_visible and
+                findNearestSample(data, last_cursor_position_,
+                                  _cursor_readout_distance, point)) {
+                addReadout(i, data.curve, data.label, point);
+            }
+        }
+    } else {
+        std::lock_guard<std::mutex> curves_lock(curves_lock_);
+        for (size_t i = 0; i < curves_.size(); ++i) {
+            auto& data = *curves_[i];
+            if (hidden_curves_.count(data.id)) {
+                continue;
+            }
+            if (findNearestSample(data, last_cursor_position_,
+                                  _cursor_readout_distance, point)) {
+                addReadout(i, data.id, data.label, point);
+            }
+        }
+    }
+
+    PointXY position{getXPosition() + 10, getYPosition() + getHeight() - 10};
+    saveColor();
+    if (readouts.empty()) {
+        PointXY p = scaleToGraph(last_cursor_position_);
+        setColor(Colors::Black);
+        drawText(std::to_string(p.first) + ", " + std::to_string(p.second),
+                 position);
+    }
+    for (const auto& readout : readouts) {
+        setColor(palette_[readout.first % palette_.size()]);
+        drawText(readout.second, position);
+        position.first += measureText(readout.second).first + 20;
+    }
+    restoreColor();
+}
+
 void RTPlotCore::hideLabels() {
     if (display_labels_) {
         display_labels_ = false;
+        invalidate();
         display_labels_btn_text_ = "+";
         label_area_width_ = 0;
 
@@ -179,107 +1634,621 @@ void RTPlotCore::hideLabels() {
     }
 }
 
-void RTPlotCore::toggleLabels() {
-    toggle_labels_ = true;
+void RTPlotCore::toggleLabels() {
+    toggle_labels_ = true;
+}
+
+void RTPlotCore::setSubdivisions(int sub) {
+    invalidate();
+    assert(sub > 0);
+    subdivisions_ = sub;
+}
+
+void RTPlotCore::setXRange(float min, float max) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    xrange_ = std::make_pair(min, max);
+    auto_xrange_ = false;
+    // Shared curves may still be displayed with an automatic range by another
+    // plot
+    for (auto& data : curves_) {
+        auto lock = lockCurve(*data);
+        if (data->plots.size() == 1) {
+            data->track_x_extrema = false;
+        }
+    }
+    invalidate();
+}
+
+void RTPlotCore::setYRange(float min, float max) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    yrange_ = std::make_pair(min, max);
+    auto_yrange_ = false;
+    // Shared curves may still be displayed with an automatic range by another
+    // plot
+    for (auto& data : curves_) {
+        auto lock = lockCurve(*data);
+        if (data->plots.size() == 1) {
+            data->track_y_extrema = false;
+        }
+    }
+    invalidate();
+}
+
+void RTPlotCore::setXLabel(const std::string& label) {
+    invalidate();
+    xlabel_ = label;
+}
+
+void RTPlotCore::setYLabel(const std::string& label) {
+    invalidate();
+    ylabel_ = label;
+}
+
+void RTPlotCore::setPlotName(const std::string& name) {
+    invalidate();
+    plot_name_ = name;
+}
+
+void RTPlotCore::setCurveLabel(int curve, const std::string& label) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto& data = getCurve(curve);
+    auto lock = lockCurve(data);
+    data.label = label;
+    invalidatePlots(data);
+}
+
+void RTPlotCore::setAutoXRange() {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto_xrange_ = true;
+    nice_xrange_ = emptyRange();
+    for (auto& data : curves_) {
+        auto lock = lockCurve(*data);
+        if (not data->track_x_extrema) {
+            data->track_x_extrema = true;
+            rebuildXExtrema(*data);
+        }
+    }
+    if (frame_series_) {
+        auto lock = lockCurve(frame_series_->lock_, lock_wait_);
+        frame_series_->x_extrema.clear();
+        for (auto x : frame_series_->x) {
+            frame_series_->x_extrema.push(x);
+        }
+    }
+    invalidate();
+}
+
+void RTPlotCore::setAutoYRange() {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto_yrange_ = true;
+    nice_yrange_ = emptyRange();
+    for (auto& data : curves_) {
+        auto lock = lockCurve(*data);
+        if (not data->track_y_extrema) {
+            data->track_y_extrema = true;
+            rebuildYExtrema(*data);
+        }
+    }
+    invalidate();
+}
+
+void RTPlotCore::setMaxPoints(int curve, size_t count) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto& data = getCurve(curve);
+    auto lock = lockCurve(data);
+    data.max_points = count;
+    if (auto series = data.series.load()) {
+        series->max_points = count;
+    }
+    invalidatePlots(data);
+}
+
+void RTPlotCore::setMaxPoints(size_t count) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    for (auto& data : curves_) {
+        auto lock = lockCurve(*data);
+        data->max_points = count;
+        if (auto series = data->series.load()) {
+            series->max_points = count;
+        }
+    }
+    invalidate();
+}
+
+void RTPlotCore::setColorPalette(const std::vector<Colors>& palette) {
+    invalidate();
+    palette_ = palette;
+}
+
+const std::vector<Colors>& RTPlotCore::getColorPalette() {
+    return palette_;
+}
+
+void RTPlotCore::setCurveVisibility(int curve, bool visibility) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    getCurve(curve);
+    if (visibility) {
+        hidden_curves_.erase(curve);
+    } else {
+        hidden_curves_.insert(curve);
+    }
+    invalidate();
+}
+
+bool RTPlotCore::getCurveVisibility(int curve) const {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto data = findCurve(curve);
+    if (data == nullptr) {
+        throw std::out_of_range("Curve " + std::to_string(curve) +
+                                " doesn't exist");
+    }
+    return hidden_curves_.count(curve) == 0;
+}
+
+void RTPlotCore::toggleCurveVisibility(int curve) {
+    setCurveVisibility(curve, not getCurveVisibility(curve));
+}
+
+void RTPlotCore::enableFastPlotting() {
+    invalidate();
+    fast_plotting_ = true;
+}
+
+void RTPlotCore::disableFastPlotting() {
+    invalidate();
+    fast_plotting_ = false;
+}
+
+void RTPlotCore::enableStatistics(bool display) {
+    {
+        std::lock_guard<std::mutex> curves_lock(curves_lock_);
+        statistics_ = true;
+        for (auto& data : curves_) {
+            auto lock = lockCurve(*data);
+            if (not data->track_statistics) {
+                trackStatistics(*data);
+            }
+        }
+    }
+    display_statistics_ = display;
+    label_area_outdated_ = true;
+    invalidate();
+}
+
+void RTPlotCore::disableStatistics() {
+    {
+        std::lock_guard<std::mutex> curves_lock(curves_lock_);
+        statistics_ = false;
+        // Shared curves may still be displayed with their statistics by
+        // another plot
+        for (auto& data : curves_) {
+            auto lock = lockCurve(*data);
+            if (data->plots.size() == 1) {
+                data->track_statistics = false;
+            }
+        }
+    }
+    display_statistics_ = false;
+    label_area_outdated_ = true;
+    invalidate();
+}
+
+CurveStatistics RTPlotCore::getStatistics(int curve) const {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto data = findCurve(curve);
+    if (data == nullptr) {
+        throw std::out_of_range("Curve " + std::to_string(curve) +
+                                " doesn't exist");
+    }
+    auto lock = lockCurve(*data);
+    return readStatistics(*data);
+}
+
+bool RTPlotCore::findNearestPoint(int curve, const PointXY& position,
+                                  PointXY& point, float max_distance) {
+    std::lock_guard<std::mutex> frame_lock(frame_lock_);
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto data = findCurve(curve);
+    if (data == nullptr) {
+        throw std::out_of_range("Curve " + std::to_string(curve) +
+                                " doesn't exist");
+    }
+    if (frozen_) {
+        // Curves created after the freeze are not displayed
+        for (const auto& snapshot : render_->frame_curves) {
+            if (snapshot.curve == curve) {
+                return findNearestSample(snapshot, position, max_distance,
+                                         point);
+            }
+        }
+        return false;
+    }
+    return findNearestSample(*data, position, max_distance, point);
+}
+
+void RTPlotCore::freeze() {
+    std::lock_guard<std::mutex> frame_lock(frame_lock_);
+    if (frozen_) {
+        return;
+    }
+    // The snapshot references the curves' current segments and blocks, the
+    // producers keep appending to new ones and the removed ones stay alive
+    // until resume()
+    takeSnapshot();
+    view_xrange_ = current_xrange_;
+    view_yrange_ = current_yrange_;
+    render_->cursor_grids.clear();
+    frozen_ = true;
+    invalidate();
+}
+
+void RTPlotCore::resume() {
+    std::lock_guard<std::mutex> frame_lock(frame_lock_);
+    if (not frozen_) {
+        return;
+    }
+    frozen_ = false;
+    dragging_ = false;
+    render_->cursor_grids.clear();
+    invalidate();
+}
+
+bool RTPlotCore::isFrozen() const {
+    return frozen_;
+}
+
+void RTPlotCore::zoom(float factor, const PointXY& center) {
+    assert(factor > 0.f);
+    std::lock_guard<std::mutex> frame_lock(frame_lock_);
+    if (not frozen_) {
+        return;
+    }
+    // The point under center stays in place
+    auto scale = [factor](Pairf& range, float ratio) {
+        float fixed = range.first + ratio * (range.second - range.first);
+        range.first = fixed + (range.first - fixed) / factor;
+        range.second = fixed + (range.second - fixed) / factor;
+    };
+    scale(view_xrange_,
+          (center.first - plot_offset_.first) / plot_size_.first);
+    scale(view_yrange_,
+          1.f - (center.second - plot_offset_.second) / plot_size_.second);
+    invalidate();
+}
+
+void RTPlotCore::pan(const PointXY& offset) {
+    std::lock_guard<std::mutex> frame_lock(frame_lock_);
+    if (not frozen_) {
+        return;
+    }
+    float dx = offset.first * (view_xrange_.second - view_xrange_.first) /
+               plot_size_.first;
+    float dy = offset.second * (view_yrange_.second - view_yrange_.first) /
+               plot_size_.second;
+    view_xrange_.first -= dx;
+    view_xrange_.second -= dx;
+    view_yrange_.first += dy;
+    view_yrange_.second += dy;
+    invalidate();
+}
+
+void RTPlotCore::enableDensityPlotting(float persistence) {
+    assert(persistence >= 0.f and persistence <= 1.f);
+    persistence_ = persistence;
+    density_plotting_ = true;
+    invalidate();
 }
 
-void RTPlotCore::setSubdivisions(int sub) {
-    assert(sub > 0);
-    subdivisions_ = sub;
+void RTPlotCore::disableDensityPlotting() {
+    density_plotting_ = false;
+    invalidate();
 }
 
-void RTPlotCore::setXRange(float min, float max) {
-    xrange_ = std::make_pair(min, max);
-    auto_xrange_ = false;
+bool RTPlotCore::drawImage(const PointXY&, size_t, size_t, const uint8_t*) {
+    return false;
 }
 
-void RTPlotCore::setYRange(float min, float max) {
-    yrange_ = std::make_pair(min, max);
-    auto_yrange_ = false;
+PlotMetrics RTPlotCore::getMetrics() {
+    PlotMetrics metrics;
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    for (auto& data : curves_) {
+        auto lock = lockCurve(*data);
+        CurveMetrics curve;
+        curve.curve = data->id;
+        curve.samples = data->size();
+        curve.memory_bytes = curveMemory(*data).total();
+        curve.points_added = data->points_added;
+        curve.points_evicted = data->points_evicted;
+        metrics.points_added += curve.points_added;
+        metrics.points_evicted += curve.points_evicted;
+        metrics.curves.push_back(curve);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - last_metrics_poll_;
+    if (elapsed.count() > 0.) {
+        metrics.points_per_second =
+            double(metrics.points_added - last_metrics_points_) /
+            elapsed.count();
+    }
+    last_metrics_poll_ = now;
+    last_metrics_points_ = metrics.points_added;
+
+    metrics.frames = frames_.load(std::memory_order_relaxed);
+    metrics.lock_wait = lock_wait_.read();
+    metrics.draw_duration = draw_duration_.read();
+    return metrics;
 }
 
-void RTPlotCore::setXLabel(const std::string& label) {
-    xlabel_ = label;
+MemoryUsage RTPlotCore::getMemoryUsage(int curve) {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    auto data = findCurve(curve);
+    if (data == nullptr) {
+        throw std::out_of_range("Curve " + std::to_string(curve) +
+                                " doesn't exist");
+    }
+    auto lock = lockCurve(*data);
+    return curveMemory(*data);
 }
 
-void RTPlotCore::setYLabel(const std::string& label) {
-    ylabel_ = label;
+MemoryUsage RTPlotCore::getMemoryUsage() {
+    return getMemoryUsage({this});
 }
 
-void RTPlotCore::setPlotName(const std::string& name) {
-    plot_name_ = name;
+MemoryUsage
+RTPlotCore::getMemoryUsage(const std::vector<RTPlotCore*>& plots) {
+    MemoryUsage usage;
+    std::set<const RTPlotCore*> counted_plots;
+    std::set<const CurveData*> counted_curves;
+    for (auto plot : plots) {
+        if (plot and counted_plots.insert(plot).second) {
+            plot->accountMemory(usage, counted_curves);
+        }
+    }
+    return usage;
 }
 
-void RTPlotCore::setCurveLabel(int curve, const std::string& label) {
-    curves_data_[curve].label = label;
+MemoryUsage RTPlotCore::getGlobalMemoryUsage() {
+    auto& registry = plotRegistry();
+    std::lock_guard<std::mutex> registry_lock(registry.lock);
+    return getMemoryUsage(registry.plots);
 }
 
-void RTPlotCore::setAutoXRange() {
-    auto_xrange_ = true;
-    for (auto& data : curves_data_) {
-        auto& ordered_list = data.second.ordered_list.first;
-        auto& previous_insertion_point =
-            data.second.previous_insertion_point.first;
-        auto& points = data.second.points;
+void RTPlotCore::setMemoryBudget(size_t bytes) {
+    memory_budget.store(bytes, std::memory_order_relaxed);
+    enforceMemoryBudget(true);
+}
 
-        ordered_list.clear();
-        for (auto point : points) {
-            previous_insertion_point = ordered_list.insert(point.first);
+size_t RTPlotCore::getMemoryBudget() {
+    return memory_budget.load(std::memory_order_relaxed);
+}
+
+void RTPlotCore::accountMemory(MemoryUsage& usage,
+                               std::set<const CurveData*>& counted) {
+    {
+        std::lock_guard<std::mutex> frame_lock(frame_lock_);
+        size_t bytes =
+            render_->commands.memoryUsage() +
+            render_->frame_curves.capacity() * sizeof(CurveSnapshot) +
+            decoded_points_.capacity() * sizeof(PointXY) +
+            decoded_values_.capacity() * sizeof(float) +
+            treeNodesMemory(render_->screen_caches) +
+            treeNodesMemory(render_->densities) +
+            treeNodesMemory(render_->cursor_grids) +
+            snapshotMemory(render_->lookup);
+        for (const auto& snapshot : render_->frame_curves) {
+            bytes += snapshotMemory(snapshot);
+        }
+        for (const auto& cache : render_->screen_caches) {
+            bytes += cache.second.memoryUsage();
+        }
+        for (const auto& density : render_->densities) {
+            bytes += density.second.histogram.memoryUsage();
         }
+        for (const auto& cursor : render_->cursor_grids) {
+            if (cursor.second.grid) {
+                bytes += sizeof(PointGrid) + cursor.second.grid->memoryUsage();
+            }
+        }
+        for (auto ticks : {&xtick_values_, &ytick_values_}) {
+            bytes += ticks->capacity() * sizeof(std::string);
+            for (const auto& tick : *ticks) {
+                bytes += tick.capacity();
+            }
+        }
+        usage.rendering += bytes;
     }
-}
 
-void RTPlotCore::setAutoYRange() {
-    auto_yrange_ = true;
-    for (auto& data : curves_data_) {
-        auto& ordered_list = data.second.ordered_list.second;
-        auto& previous_insertion_point =
-            data.second.previous_insertion_point.second;
-        auto& points = data.second.points;
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    usage.rendering += treeNodesMemory(derived_curves_) +
+                       render_->derived_sources.capacity() *
+                           sizeof(CurveSnapshot) +
+                       derived_samples_.capacity() * sizeof(PointXY);
+    for (const auto& derived : derived_curves_) {
+        usage.rendering += derived.second->memoryUsage();
+    }
+    for (const auto& snapshot : render_->derived_sources) {
+        usage.rendering += snapshotMemory(snapshot);
+    }
 
-        ordered_list.clear();
-        for (auto point : points) {
-            previous_insertion_point = ordered_list.insert(point.second);
+    usage.other += (curves_.capacity() + detached_curves_.capacity()) *
+                       sizeof(std::shared_ptr<CurveData>) +
+                   treeNodesMemory(hidden_curves_) +
+                   curve_shards * sizeof(CurveShard);
+    for (size_t i = 0; i < curve_shards; ++i) {
+        std::lock_guard<std::mutex> shard_lock(shards_[i].lock);
+        usage.other += shards_[i].curves.capacity() * sizeof(CurveData*);
+    }
+    for (auto curves : {&curves_, &detached_curves_}) {
+        for (auto& data : *curves) {
+            if (counted.insert(data.get()).second) {
+                auto lock = lockCurve(*data);
+                usage += curveMemory(*data);
+            }
         }
     }
+    if (frame_series_) {
+        std::lock_guard<PriorityMutex> lock(frame_series_->lock_);
+        usage += seriesMemory(*frame_series_);
+    }
 }
 
-void RTPlotCore::setMaxPoints(int curve, size_t count) {
-    curves_data_[curve].max_points = count;
-}
+void RTPlotCore::enforceMemoryBudget(bool force) {
+    size_t budget = memory_budget.load(std::memory_order_relaxed);
+    if (budget == 0) {
+        return;
+    }
+    // Only one renderer checks the budget at a time, the others keep drawing
+    auto& registry = plotRegistry();
+    std::unique_lock<std::mutex> registry_lock(registry.lock,
+                                               std::defer_lock);
+    if (force) {
+        registry_lock.lock();
+    } else if (not registry_lock.try_lock()) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (not force and
+        now - registry.last_budget_check < _memory_check_period) {
+        return;
+    }
+    registry.last_budget_check = now;
 
-void RTPlotCore::setMaxPoints(size_t count) {
-    for (auto& data : curves_data_) {
-        data.second.max_points = count;
+    size_t total = getMemoryUsage(registry.plots).total();
+    if (total <= budget) {
+        return;
     }
-}
 
-void RTPlotCore::setColorPalette(const std::vector<Colors>& palette) {
-    palette_ = palette;
+    // Curves holding samples, the one with the oldest samples first. A frame
+    // series is evicted through its first channel. The curves stay alive
+    // while their plot is registered, replaced ones being kept as detached
+    struct Candidate {
+        uint64_t age;
+        RTPlotCore* plot;
+        CurveData* data;
+    };
+    std::vector<Candidate> candidates;
+    std::set<const CurveData*> seen;
+    for (auto plot : registry.plots) {
+        std::lock_guard<std::mutex> curves_lock(plot->curves_lock_);
+        for (auto& data : plot->curves_) {
+            if (not seen.insert(data.get()).second) {
+                continue;
+            }
+            auto lock = lockCurve(*data);
+            auto series = data->series.load(std::memory_order_relaxed);
+            if (data->size() > 0 and
+                (series == nullptr or series->channels.front() == data.get())) {
+                candidates.push_back(
+                    Candidate{oldestSampleAge(*data), plot, data.get()});
+            }
+        }
+    }
+    auto newer = [](const Candidate& a, const Candidate& b) {
+        return a.age > b.age;
+    };
+    std::make_heap(candidates.begin(), candidates.end(), newer);
+    while (total > budget and not candidates.empty()) {
+        std::pop_heap(candidates.begin(), candidates.end(), newer);
+        auto candidate = candidates.back();
+        candidates.pop_back();
+        auto& data = *candidate.data;
+        auto lock = lockCurve(data);
+        size_t freed = candidate.plot->evictOldestSamples(data);
+        total -= std::min(total, freed);
+        // The curves whose oldest samples can't be freed are left alone
+        if (freed > 0 and data.size() > 0) {
+            candidates.push_back(
+                Candidate{oldestSampleAge(data), candidate.plot, &data});
+            std::push_heap(candidates.begin(), candidates.end(), newer);
+        }
+    }
 }
 
-const std::vector<Colors>& RTPlotCore::getColorPalette() {
-    return palette_;
-}
+size_t RTPlotCore::evictOldestSamples(CurveData& data) {
+    if (oldestSamplesShared(data) or withinReserve(data)) {
+        return 0;
+    }
+    auto series = data.series.load(std::memory_order_relaxed);
+    auto memory = [&data, series] {
+        if (series == nullptr) {
+            return curveMemory(data).total();
+        }
+        size_t bytes = seriesMemory(*series).total();
+        for (auto channel : series->channels) {
+            bytes += curveMemory(*channel).total();
+        }
+        return bytes;
+    };
+    size_t before = memory();
+
+    // The samples added at about the same time, up to the next age mark
+    uint64_t end = data.first_sample + data.size();
+    oldestSampleAge(data);
+    if (data.age_marks.size() > 1) {
+        end = std::min(end, data.age_marks[1].first);
+    }
+    while (data.first_sample < end and data.size() > 0) {
+        if (series) {
+            popFrontFrame(*series);
+            for (auto channel : series->channels) {
+                ++channel->points_evicted;
+            }
+        } else {
+            popFront(data);
+            ++data.points_evicted;
+        }
+    }
 
-void RTPlotCore::setCurveVisibility(int curve, bool visibility) {
-    curves_data_[curve].is_visible = visibility;
+    // The pooled storage is freed too, otherwise evicting wouldn't lower the
+    // memory usage of the curves having grown past their reserved storage.
+    // The reserved part is kept so that their producers still don't allocate
+    if (series) {
+        series->x.releaseSpare();
+        for (auto channel : series->channels) {
+            channel->values.releaseSpare();
+        }
+    } else {
+        data.points.releaseSpare();
+        data.values.releaseSpare();
+    }
+    invalidatePlots(data);
+
+    size_t after = memory();
+    return before > after ? before - after : 0;
 }
 
-bool RTPlotCore::getCurveVisibility(int curve) const {
-    return curves_data_.at(curve).is_visible;
+FrameProfile RTPlotCore::getFrameProfile() const {
+    if (profiler_) {
+        return profiler_->read();
+    }
+    return FrameProfile{};
 }
 
-void RTPlotCore::toggleCurveVisibility(int curve) {
-    setCurveVisibility(curve, not getCurveVisibility(curve));
+void RTPlotCore::setFrameBudget(float budget_ms) {
+    invalidate();
+    frame_budget_ms_ = budget_ms;
+    if (budget_ms <= 0.f) {
+        quality_ = QualityLevel::Full;
+    }
 }
 
-void RTPlotCore::enableFastPlotting() {
-    fast_plotting_ = true;
+QualityLevel RTPlotCore::getQualityLevel() const {
+    return quality_;
 }
 
-void RTPlotCore::disableFastPlotting() {
-    fast_plotting_ = false;
+void RTPlotCore::resetMetrics() {
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    for (auto& data : curves_) {
+        auto lock = lockCurve(*data);
+        data->points_added = 0;
+        data->points_evicted = 0;
+    }
+    last_metrics_poll_ = std::chrono::steady_clock::now();
+    last_metrics_points_ = 0;
+    frames_ = 0;
+    lock_wait_.reset();
+    draw_duration_.reset();
 }
 
 void RTPlotCore::labelsToggleButtonCallback() {
@@ -299,10 +2268,29 @@ RTPlotCore::Pairf RTPlotCore::getToggleButtonPosition() {
                  getYPosition() + 10};
 }
 
+void RTPlotCore::prepareFrame() {
+    RTPLOT_PROFILE_PHASE(profiler_.get(), FramePhase::Prepare);
+    auto prepare_start = std::chrono::steady_clock::now();
+    enforceMemoryBudget(false);
+    std::lock_guard<std::mutex> frame_lock(frame_lock_);
+    // drawPlot() computes the layout since only the GUI thread can read the
+    // widget's geometry
+    if (widget_.width > 0 and frame_outdated_.load(std::memory_order_relaxed)) {
+        buildFrame();
+    }
+    // Accounted for in the duration of the next drawPlot() call
+    prepare_duration_ += std::chrono::steady_clock::now() - prepare_start;
+}
+
 void RTPlotCore::drawPlot() {
-    saveColor();
+    auto draw_start = std::chrono::steady_clock::now();
+    // Not done while building the frame since checking the budget locks the
+    // frame of all the plots
+    enforceMemoryBudget(false);
+    std::lock_guard<std::mutex> frame_lock(frame_lock_);
 
     if (toggle_labels_) {
+        RTPLOT_PROFILE_PHASE(profiler_.get(), FramePhase::LabelsToggle);
         toggle_labels_ = false;
         if (display_labels_) {
             hideLabels();
@@ -310,67 +2298,343 @@ void RTPlotCore::drawPlot() {
             displayLabels();
         }
     }
+    if (label_area_outdated_.exchange(false) and display_labels_) {
+        updateLabelAreaWidth();
+    }
+
+    // Replay the prepared frame if it is still valid (e.g on expose events),
+    // otherwise record a new one now
+    bool layout_changed = computeLayout(readWidgetGeometry());
+    if (layout_changed or frame_outdated_.load(std::memory_order_relaxed)) {
+        RTPLOT_PROFILE_PHASE(profiler_.get(), FramePhase::Prepare);
+        buildFrame();
+    }
+
+    replay(render_->commands);
+
+    if (display_cursor_coordinates_) {
+        RTPLOT_PROFILE_PHASE(profiler_.get(), FramePhase::CursorText);
+        drawCursorReadout();
+    }
+    if (not render_->cursor_lookups) {
+        render_->cursor_grids.clear();
+    }
+    render_->cursor_lookups = false;
+
+    // The frame is most of the time built in advance by prepareFrame()
+    auto draw_time =
+        std::chrono::steady_clock::now() - draw_start + prepare_duration_;
+    prepare_duration_ = std::chrono::steady_clock::duration::zero();
+    frames_.fetch_add(1, std::memory_order_relaxed);
+    draw_duration_.record(draw_time);
+    updateQuality(
+        std::chrono::duration<float, std::milli>(draw_time).count());
+}
+
+void RTPlotCore::updateQuality(float draw_time_ms) {
+    // Smoothing factor of the draw time moving average
+    constexpr float smoothing = 0.2f;
+    // Frames to wait after a change to let the average reflect the new level
+    constexpr size_t settling_frames = 10;
+    // Frames well below the budget required before increasing the quality
+    constexpr size_t recovery_frames = 30;
+
+    float budget_ms = frame_budget_ms_;
+    if (budget_ms <= 0.f) {
+        return;
+    }
+
+    average_draw_time_ms_ += smoothing * (draw_time_ms - average_draw_time_ms_);
+    if (++frames_since_quality_change_ < settling_frames) {
+        return;
+    }
+
+    auto level = static_cast<int>(quality_.load());
+    if (average_draw_time_ms_ > budget_ms) {
+        frames_under_budget_ = 0;
+        if (quality_ != QualityLevel::Minimal) {
+            quality_ = static_cast<QualityLevel>(level + 1);
+            invalidate();
+            frames_since_quality_change_ = 0;
+        }
+    } else if (average_draw_time_ms_ < 0.5f * budget_ms) {
+        if (++frames_under_budget_ >= recovery_frames and
+            quality_ != QualityLevel::Full) {
+            quality_ = static_cast<QualityLevel>(level - 1);
+            invalidate();
+            frames_since_quality_change_ = 0;
+            frames_under_budget_ = 0;
+        }
+    } else {
+        frames_under_budget_ = 0;
+    }
+}
+
+void RTPlotCore::takeSnapshot() {
+    RTPLOT_PROFILE_PHASE(profiler_.get(), FramePhase::Snapshot);
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    updateDerivedCurves();
+
+    // The automatic ranges are computed here rather than on each new point
+    // so that the producers only have to update their own curve
+    bool auto_xrange = auto_xrange_;
+    bool auto_yrange = auto_yrange_;
+    xrange_auto_ = emptyRange();
+    yrange_auto_ = emptyRange();
+
+    render_->frame_curves.resize(curves_.size());
+    auto snapshot = render_->frame_curves.begin();
+    for (auto& data : curves_) {
+        bool is_visible = hidden_curves_.count(data->id) == 0;
+        auto lock = lockCurve(*data, lock_wait_);
+        auto series = data->series.load(std::memory_order_relaxed);
+        const auto& x_extrema = series ? series->x_extrema : data->x_extrema;
+        // Triggered curves are replaced by their sweeps, handled below
+        bool is_live = is_visible and not data->trigger;
+        if (is_live and auto_xrange and data->size() > 0) {
+            if (data->is_uniform) {
+                // Samples are stored by increasing x
+                xrange_auto_.first =
+                    std::min(xrange_auto_.first, data->sampleX(0));
+                xrange_auto_.second = std::max(
+                    xrange_auto_.second, data->sampleX(data->size() - 1));
+            } else if (not x_extrema.empty()) {
+                xrange_auto_.first =
+                    std::min(xrange_auto_.first, x_extrema.min());
+                xrange_auto_.second =
+                    std::max(xrange_auto_.second, x_extrema.max());
+            }
+        }
+        if (is_live and auto_yrange and not data->y_extrema.empty()) {
+            yrange_auto_.first =
+                std::min(yrange_auto_.first, data->y_extrema.min());
+            yrange_auto_.second =
+                std::max(yrange_auto_.second, data->y_extrema.max());
+        }
+
+        captureCurve(*data, *snapshot);
+        snapshot->is_visible = is_visible;
+        for (const auto& sweep : snapshot->sweeps) {
+            if (is_visible and auto_xrange) {
+                xrange_auto_.first = std::min(xrange_auto_.first, sweep->xmin);
+                xrange_auto_.second =
+                    std::max(xrange_auto_.second, sweep->xmax);
+            }
+            if (is_visible and auto_yrange) {
+                yrange_auto_.first = std::min(yrange_auto_.first, sweep->ymin);
+                yrange_auto_.second =
+                    std::max(yrange_auto_.second, sweep->ymax);
+            }
+        }
+        ++snapshot;
+    }
+
+    current_xrange_ = auto_xrange
+                          ? autoRange(xrange_auto_, nice_xrange_, subdivisions_)
+                          : xrange_;
+    current_yrange_ = auto_yrange
+                          ? autoRange(yrange_auto_, nice_yrange_, subdivisions_)
+                          : yrange_;
+}
+
+void RTPlotCore::updateDerivedCurves() {
+    for (auto& derived : derived_curves_) {
+        int curve = derived.first;
+        if (hidden_curves_.count(curve)) {
+            continue;
+        }
+        // The sources are only locked while referencing their storage, the
+        // evaluation itself doesn't block the producers
+        const auto& sources = derived.second->sources();
+        render_->derived_sources.resize(sources.size());
+        for (size_t i = 0; i < sources.size(); ++i) {
+            auto& source = getCurve(sources[i]);
+            auto lock = lockCurve(source, lock_wait_);
+            captureCurve(source, render_->derived_sources[i]);
+        }
+        derived_samples_.clear();
+        bool replace =
+            derived.second->update(render_->derived_sources, derived_samples_);
+        for (auto& snapshot : render_->derived_sources) {
+            snapshot.clear();
+        }
+        if (not replace and derived_samples_.empty()) {
+            continue;
+        }
+
+        auto& data = getCurve(curve);
+        auto lock = lockCurve(data, lock_wait_);
+        if (replace) {
+            clearSamples(data);
+        }
+        for (const auto& sample : derived_samples_) {
+            storePoint(data, sample.first, sample.second);
+        }
+        data.points_added += derived_samples_.size();
+        // This plot is being redrawn, only the other ones displaying the
+        // curve have to be notified
+        for (auto plot : data.plots) {
+            if (plot != this) {
+                plot->invalidateData();
+            }
+        }
+    }
+}
+
+RTPlotCore::WidgetGeometry RTPlotCore::readWidgetGeometry() {
+    return WidgetGeometry{getWidth(), getHeight(), getXPosition(),
+                          getYPosition()};
+}
+
+bool RTPlotCore::computeLayout(const WidgetGeometry& widget) {
+    widget_ = widget;
+    Pairf plot_size(
+        widget.width - _plot_margin_left - _plot_margin_right -
+            label_area_width_,
+        widget.height - _plot_margin_top - _plot_margin_bottom);
+    PointXY plot_offset(widget.x + _plot_margin_left,
+                        widget.y + _plot_margin_top);
+
+    bool changed = plot_size != plot_size_ or plot_offset != plot_offset_;
+    plot_size_ = plot_size;
+    plot_offset_ = plot_offset;
+    return changed;
+}
+
+void RTPlotCore::buildFrame() {
+    // Clear the flag first so that any modification made during the snapshot
+    // invalidates the frame. The curves' locks taken by the snapshot order
+    // this with the producers' writes
+    frame_outdated_.store(false, std::memory_order_relaxed);
+    if (frozen_) {
+        refreshFrozenSnapshot();
+    } else {
+        takeSnapshot();
+    }
+    initScaleToPlot();
+    computeTicks();
 
-    plot_size_ = std::make_pair(
-        getWidth() - _plot_margin_left - _plot_margin_right - label_area_width_,
-        getHeight() - _plot_margin_top - _plot_margin_bottom);
-    plot_offset_ = std::make_pair(getXPosition() + _plot_margin_left,
-                                  getYPosition() + _plot_margin_top);
+    render_->commands.clear();
+    render_->commands.saveColor();
 
-    if (display_labels_)
+    if (display_labels_ and quality_ < QualityLevel::Minimal)
         drawLabels();
 
     drawAxes();
 
-    // Avoid drawing outside of the plot area
-    pushClip(plot_offset_, plot_size_);
-    int idx = 0;
-    initScaleToPlot();
-    for (auto& data : curves_data_) {
-        std::lock_guard<std::mutex> lock(data.second.lock_);
-        if (not data.second.is_visible) {
-            idx++;
-            continue;
+    // Avoid drawing outside of the plot area. The state kept for the drawing
+    // mode not in use is released
+    render_->commands.pushClip(plot_offset_, plot_size_);
+    if (density_plotting_ and not images_unsupported_) {
+        render_->screen_caches.clear();
+        drawDensity();
+    } else {
+        render_->densities.clear();
+        drawCurves();
+    }
+    render_->commands.popClip();
+
+    render_->commands.restoreColor();
+
+    // The samples are not needed anymore once recorded, release them so that
+    // the producers can reuse their storage. A frozen plot keeps them until
+    // it is resumed
+    if (not frozen_) {
+        for (auto& data : render_->frame_curves) {
+            data.clear();
         }
-        auto& c = data.second.points;
-        if (c.size() > 1) {
-            PointXY prev, curr;
-            auto it = c.begin();
-            float dx = plot_size_.first / c.size();
-            int prev_x = 0;
-            float x = 0.f;
+    }
+}
 
-            scaleToPlot(*it, prev);
+void RTPlotCore::refreshFrozenSnapshot() {
+    RTPLOT_PROFILE_PHASE(profiler_.get(), FramePhase::Snapshot);
+    std::lock_guard<std::mutex> curves_lock(curves_lock_);
+    for (auto& data : render_->frame_curves) {
+        data.is_visible = hidden_curves_.count(data.curve) == 0;
+    }
+    current_xrange_ = view_xrange_;
+    current_yrange_ = view_yrange_;
+}
 
-            setColor(palette_[idx++ % palette_.size()]);
+void RTPlotCore::replay(const RenderCommandBuffer& buffer) {
+    RTPLOT_PROFILE_PHASE(profiler_.get(), FramePhase::Replay);
+    using Op = RenderCommandBuffer::Op;
+    const auto& points = buffer.points();
+    for (const auto& cmd : buffer.commands()) {
+        switch (cmd.op) {
+        case Op::PushClip:
+            pushClip(points[cmd.index], points[cmd.index + 1]);
+            break;
+        case Op::PopClip:
+            popClip();
+            break;
+        case Op::StartLine:
             startLine();
-            for (++it; it != c.end(); ++it) {
-                if (fast_plotting_) {
-                    x += dx;
-                    if (int(x) > prev_x) {
-                        prev_x = int(x);
-                    } else {
-                        continue;
-                    }
-                }
-                scaleToPlot(*it, curr);
-                drawLine(prev, curr);
-                prev = curr;
+            break;
+        case Op::Polyline:
+            for (size_t i = cmd.index + 1; i < cmd.index + cmd.count; ++i) {
+                drawLine(points[i - 1], points[i]);
             }
+            break;
+        case Op::EndLine:
             endLine();
+            break;
+        case Op::SetLineStyle:
+            setLineStyle(static_cast<LineStyle>(cmd.arg));
+            break;
+        case Op::SetColor:
+            setColor(static_cast<Colors>(cmd.arg));
+            break;
+        case Op::SaveColor:
+            saveColor();
+            break;
+        case Op::RestoreColor:
+            restoreColor();
+            break;
+        case Op::DrawText: {
+            const auto& text = buffer.text(cmd.count);
+            const auto& position = points[cmd.index];
+            const auto& width_offset = points[cmd.index + 1];
+            const auto& height_offset = points[cmd.index + 2];
+            auto size = measureText(text);
+            drawText(text,
+                     PointXY{position.first + size.first * width_offset.first +
+                                 size.second * height_offset.first,
+                             position.second +
+                                 size.first * width_offset.second +
+                                 size.second * height_offset.second},
+                     cmd.arg);
+        } break;
+        case Op::DrawImage: {
+            const auto& size = points[cmd.index + 1];
+            if (not drawImage(points[cmd.index], size_t(size.first),
+                              size_t(size.second), buffer.image(cmd.count))) {
+                // Fall back to lines starting from the next frame
+                images_unsupported_ = true;
+                invalidate();
+            }
+        } break;
         }
     }
-    popClip();
+}
 
-    if (display_cursor_coordinates_) {
-        PointXY p = scaleToGraph(last_cursor_position_);
-        setColor(Colors::Black);
-        drawText(
-            std::to_string(p.first) + ", " + std::to_string(p.second),
-            PointXY{getXPosition() + 10, getYPosition() + getHeight() - 10});
-    }
+void RTPlotCore::computeTicks() {
+    const auto& xrange = current_xrange_;
+    const auto& yrange = current_yrange_;
+    int nticks = 4 * subdivisions_;
+    float xtick_range = float(xrange.second - xrange.first) / float(nticks);
+    float ytick_range = float(yrange.second - yrange.first) / float(nticks);
 
-    restoreColor();
+    char str[15];
+    xtick_values_.resize(subdivisions_);
+    ytick_values_.resize(subdivisions_);
+    for (int i = 0; i < subdivisions_; ++i) {
+        int tick = 4 * (i + 1);
+        snprintf(str, 15, "%.2f", tick * xtick_range + xrange.first);
+        xtick_values_[i] = str;
+        snprintf(str, 15, "%.2f", tick * ytick_range + yrange.first);
+        ytick_values_[i] = str;
+    }
 }
 
 void RTPlotCore::handleWidgetEvent(MouseEvent event, PointXY cursor_position) {
@@ -382,57 +2646,80 @@ void RTPlotCore::handleWidgetEvent(MouseEvent event, PointXY cursor_position) {
         display_cursor_coordinates_ = false;
         break;
     case MouseEvent::MoveInsideWidget:
+        if (dragging_) {
+            pan(PointXY(cursor_position.first - last_cursor_position_.first,
+                        cursor_position.second -
+                            last_cursor_position_.second));
+        }
         last_cursor_position_ = cursor_position;
         break;
     case MouseEvent::LeftClick:
         handleLeftClick(cursor_position);
         break;
+    case MouseEvent::MiddleClick:
+        if (frozen_) {
+            resume();
+        } else {
+            freeze();
+        }
+        break;
+    case MouseEvent::LeftButtonPressed:
+        last_cursor_position_ = cursor_position;
+        dragging_ = frozen_ and insidePlot(cursor_position);
+        break;
+    case MouseEvent::LeftButtonReleased:
+        dragging_ = false;
+        break;
+    case MouseEvent::WheelUp:
+        zoom(_wheel_zoom_factor, cursor_position);
+        break;
+    case MouseEvent::WheelDown:
+        zoom(1.f / _wheel_zoom_factor, cursor_position);
+        break;
     default:
         break;
     }
 }
 
 void RTPlotCore::drawAxes() {
-    Pairf xrange, yrange;
-    xrange = auto_xrange_ ? xrange_auto_ : xrange_;
-    yrange = auto_yrange_ ? yrange_auto_ : yrange_;
-    setColor(Colors::Black);
-    auto txt_size = measureText(ylabel_);
-    drawText(
-        ylabel_,
-        PointXY{getXPosition() + 10 + txt_size.second / 2,
-                plot_offset_.second + (plot_size_.second + txt_size.first) / 2},
-        90);
-
-    txt_size = measureText(xlabel_);
-    drawText(xlabel_, PointXY{plot_offset_.first +
-                                  (plot_size_.first - txt_size.first) / 2,
-                              plot_offset_.second + plot_size_.second + 40});
-
-    txt_size = measureText(plot_name_);
-    drawText(plot_name_, PointXY{plot_offset_.first +
-                                     (plot_size_.first - txt_size.first) / 2,
-                                 plot_offset_.second - txt_size.second / 2});
+    RTPLOT_PROFILE_PHASE(profiler_.get(), FramePhase::Axes);
+    render_->commands.setColor(Colors::Black);
+    render_->commands.text(ylabel_,
+                           PointXY{widget_.x + 10,
+                                   plot_offset_.second + plot_size_.second / 2},
+                           PointXY{0.f, 0.5f}, PointXY{0.5f, 0.f}, 90);
+
+    render_->commands.text(
+        xlabel_,
+        PointXY{plot_offset_.first + plot_size_.first / 2,
+                plot_offset_.second + plot_size_.second + 40},
+        PointXY{-0.5f, 0.f});
+
+    render_->commands.text(plot_name_,
+                           PointXY{plot_offset_.first + plot_size_.first / 2,
+                                   plot_offset_.second},
+                           PointXY{-0.5f, 0.f}, PointXY{0.f, -0.5f});
 
     // Y axis line
-    startLine();
-    drawLine(plot_offset_, PointXY{plot_offset_.first,
+    render_->commands.startLine();
+    render_->commands.line(plot_offset_,
+                           PointXY{plot_offset_.first,
                                    plot_offset_.second + plot_size_.second});
-    endLine();
+    render_->commands.endLine();
     // X axis line
-    startLine();
-    drawLine(
+    render_->commands.startLine();
+    render_->commands.line(
         PointXY{plot_offset_.first, plot_offset_.second + plot_size_.second},
         PointXY{plot_offset_.first + plot_size_.first,
                 plot_offset_.second + plot_size_.second});
-    endLine();
+    render_->commands.endLine();
 
-    // Draw axes ticks
-    int nticks = 4 * subdivisions_;
+    // Draw axes ticks, using the subdivisions the tick values were computed
+    // for
+    bool draw_grid = quality_ < QualityLevel::Reduced;
+    int nticks = 4 * int(xtick_values_.size());
     float xtick = plot_size_.first / float(nticks);
     float ytick = plot_size_.second / float(nticks);
-    float xtick_range = float(xrange.second - xrange.first) / float(nticks);
-    float ytick_range = float(yrange.second - yrange.first) / float(nticks);
     for (int i = 1; i <= nticks; ++i) {
         float xstart, xend, ystart, yend;
         // X axis tick
@@ -444,22 +2731,24 @@ void RTPlotCore::drawAxes() {
         else {
             yend -= 6; // big tick
             // Verical dashed gray line
-            saveColor();
-            setColor(Colors::Gray);
-            setLineStyle(LineStyle::Dotted);
-            startLine();
-            drawLine(PointXY{xstart, ystart - 6},
-                     PointXY{xend, plot_offset_.second});
-            endLine();
-            restoreColor();
-            setLineStyle(LineStyle::Solid);
+            if (draw_grid) {
+                render_->commands.saveColor();
+                render_->commands.setColor(Colors::Gray);
+                render_->commands.setLineStyle(int(LineStyle::Dotted));
+                render_->commands.startLine();
+                render_->commands.line(PointXY{xstart, ystart - 6},
+                                       PointXY{xend, plot_offset_.second});
+                render_->commands.endLine();
+                render_->commands.restoreColor();
+                render_->commands.setLineStyle(int(LineStyle::Solid));
+            }
 
-            drawXTickValue(i * xtick_range + xrange.first,
+            drawXTickValue(xtick_values_[i / 4 - 1],
                            std::make_pair(xstart, ystart));
         }
-        startLine();
-        drawLine(PointXY{xstart, ystart}, PointXY{xend, yend});
-        endLine();
+        render_->commands.startLine();
+        render_->commands.line(PointXY{xstart, ystart}, PointXY{xend, yend});
+        render_->commands.endLine();
 
         // Y axis tick
         xstart = xend = plot_offset_.first;
@@ -470,64 +2759,307 @@ void RTPlotCore::drawAxes() {
         else {
             xend += 6; // big tick
             // Horizontal dashed gray line
-            saveColor();
-            setColor(Colors::Gray);
-            setLineStyle(LineStyle::Dotted);
-            startLine();
-            drawLine(PointXY{xstart + 6, ystart},
-                     PointXY{plot_offset_.first + plot_size_.first, yend});
-            endLine();
-            restoreColor();
-            setLineStyle(LineStyle::Solid);
+            if (draw_grid) {
+                render_->commands.saveColor();
+                render_->commands.setColor(Colors::Gray);
+                render_->commands.setLineStyle(int(LineStyle::Dotted));
+                render_->commands.startLine();
+                render_->commands.line(
+                    PointXY{xstart + 6, ystart},
+                    PointXY{plot_offset_.first + plot_size_.first, yend});
+                render_->commands.endLine();
+                render_->commands.restoreColor();
+                render_->commands.setLineStyle(int(LineStyle::Solid));
+            }
 
-            drawYTickValue(i * ytick_range + yrange.first,
+            drawYTickValue(ytick_values_[i / 4 - 1],
                            std::make_pair(xstart, ystart));
         }
-        startLine();
-        drawLine(PointXY{xstart, ystart}, PointXY{xend, yend});
-        endLine();
+        render_->commands.startLine();
+        render_->commands.line(PointXY{xstart, ystart}, PointXY{xend, yend});
+        render_->commands.endLine();
+    }
+}
+
+void RTPlotCore::drawCurves() {
+    RTPLOT_PROFILE_PHASE(profiler_.get(), FramePhase::Curves);
+    auto quality = quality_.load();
+    bool decimate = fast_plotting_ or quality >= QualityLevel::Decimated;
+    float pixels_per_point = quality == QualityLevel::Minimal ? 2.f : 1.f;
+
+    // Segments are clipped to the plot area and merged here rather than
+    // leaving it to the backend, which can be slow with long curves
+    PolylineClipper clipper(render_->commands);
+
+    int idx = 0;
+    for (auto& data : render_->frame_curves) {
+        if (not data.is_visible) {
+            idx++;
+            continue;
+        }
+        RTPLOT_PROFILE_CURVE(profiler_.get(), data.curve);
+
+        if (data.triggered) {
+            render_->commands.setColor(palette_[idx++ % palette_.size()]);
+            drawSweeps(data, clipper, pixels_per_point);
+            continue;
+        }
+
+        auto& values = data.values;
+        auto& points = data.points;
+        bool has_values = data.is_uniform or data.is_series;
+        size_t count =
+            data.cold_size + (has_values ? values.size() : points.size());
+        auto sampleX = [&data](size_t i) {
+            return float(data.x0 + double(i) * data.dx);
+        };
+        auto rawSample = [&](size_t i) {
+            if (data.is_uniform) {
+                return PointXY(sampleX(i), values[i - data.cold_size]);
+            } else if (data.is_series) {
+                return PointXY(data.xs[i], values[i]);
+            } else {
+                return points[i - data.cold_size];
+            }
+        };
+
+        // Only the samples of the curves with increasing x coordinates
+        // inside the x range, plus one on each side to reach the plot's
+        // borders, are drawn. This also keeps the decimation relative to the
+        // visible samples when zooming on a frozen plot
+        size_t begin = 0;
+        size_t end = count;
+        if (data.is_uniform) {
+            double first = std::floor((current_xrange_.first - data.x0) /
+                                      data.dx);
+            double last = std::ceil((current_xrange_.second - data.x0) /
+                                    data.dx);
+            begin = size_t(std::min(std::max(first, 0.), double(count)));
+            end = size_t(std::min(std::max(last + 1., 0.), double(count)));
+        } else if (data.x_increasing) {
+            SampleReader samples(data);
+            const auto& xrange = current_xrange_;
+            begin = partitionSamples(data, samples, [&xrange](float x) {
+                return x < xrange.first;
+            });
+            end = partitionSamples(data, samples, [&xrange](float x) {
+                return x <= xrange.second;
+            });
+            begin = begin ? begin - 1 : 0;
+            end = std::min(end + 1, count);
+        }
+        if (end <= begin + 1) {
+            continue;
+        }
+
+        Decimator decimator(decimate, plot_size_.first /
+                                          (pixels_per_point * (end - begin)));
+        PointXY point;
+        auto add = [this, &point, &clipper](const PointXY& graph_point) {
+            scaleToPlot(graph_point, point);
+            clipper.addPoint(point);
+        };
+
+        render_->commands.setColor(palette_[idx++ % palette_.size()]);
+        render_->commands.startLine();
+        clipper.begin(plot_offset_, plot_size_,
+                      _line_merge_tolerance * pixels_per_point);
+
+        // Compressed samples, only decoded if they are not too dense to be
+        // distinguished, otherwise their envelope is drawn
+        size_t block_begin = 0;
+        for (size_t b = 0; b < data.cold_blocks.size() and block_begin < end;
+             ++b) {
+            const auto& block = *data.cold_blocks[b];
+            size_t offset = b ? 0 : data.cold_offset;
+            size_t block_end = block_begin + block.size() - offset;
+            if (block_end > begin) {
+                size_t first = std::max(begin, block_begin);
+                size_t last = std::min(end, block_end);
+                float xmin = data.is_uniform ? sampleX(first) : block.xMin();
+                float xmax = data.is_uniform ? sampleX(last - 1) : block.xMax();
+                PointXY pmin, pmax;
+                scaleToPlot(PointXY(xmin, 0.f), pmin);
+                scaleToPlot(PointXY(xmax, 0.f), pmax);
+                float pixels = std::abs(pmax.first - pmin.first);
+                if (float(last - first) > 2.f * (pixels + 1.f)) {
+                    float xmid = 0.5f * (xmin + xmax);
+                    decimator.skip(last - first);
+                    add(PointXY(xmid, block.yMin()));
+                    add(PointXY(xmid, block.yMax()));
+                } else if (data.is_uniform) {
+                    block.decode(decoded_values_);
+                    for (size_t i = first; i < last; ++i) {
+                        if (decimator.keep()) {
+                            add(PointXY(sampleX(i),
+                                        decoded_values_[i - block_begin +
+                                                        offset]));
+                        }
+                    }
+                } else {
+                    block.decode(decoded_points_);
+                    for (size_t i = first; i < last; ++i) {
+                        if (decimator.keep()) {
+                            add(decoded_points_[i - block_begin + offset]);
+                        }
+                    }
+                }
+            }
+            block_begin = block_end;
+        }
+
+        // Raw samples, only the ones not drawn by the previous frames are
+        // transformed as long as the transform doesn't change
+        size_t raw_begin = std::max(begin, data.cold_size);
+        if (raw_begin < end) {
+            auto& cache = render_->screen_caches[data.curve];
+            uint64_t first = data.first_sample;
+            cache.update(data.generation, first + raw_begin, first + end,
+                         [&](uint64_t sample) {
+                             PointXY screen_point;
+                             scaleToPlot(rawSample(size_t(sample - first)),
+                                         screen_point);
+                             return screen_point;
+                         });
+            for (size_t i = raw_begin; i < end; ++i) {
+                if (decimator.keep()) {
+                    clipper.addPoint(cache[first + i]);
+                }
+            }
+        }
+        clipper.end();
+        render_->commands.endLine();
+    }
+
+    releaseHiddenCurves(render_->screen_caches, render_->frame_curves);
+}
+
+void RTPlotCore::drawSweeps(const CurveSnapshot& data,
+                            PolylineClipper& clipper,
+                            float pixels_per_point) {
+    // The sweeps are short so they are neither decimated nor cached
+    PointXY point;
+    for (const auto& sweep : data.sweeps) {
+        render_->commands.startLine();
+        clipper.begin(plot_offset_, plot_size_,
+                      _line_merge_tolerance * pixels_per_point);
+        for (const auto& sample : sweep->points) {
+            scaleToPlot(PointXY(sample.first - sweep->trigger_x, sample.second),
+                        point);
+            clipper.addPoint(point);
+        }
+        clipper.end();
+        render_->commands.endLine();
+    }
+}
+
+void RTPlotCore::drawDensity() {
+    RTPLOT_PROFILE_PHASE(profiler_.get(), FramePhase::Curves);
+    auto width = size_t(std::max(plot_size_.first, 0.f));
+    auto height = size_t(std::max(plot_size_.second, 0.f));
+    auto persistence = persistence_.load();
+
+    int idx = 0;
+    for (auto& data : render_->frame_curves) {
+        if (not data.is_visible) {
+            idx++;
+            continue;
+        }
+        RTPLOT_PROFILE_CURVE(profiler_.get(), data.curve);
+
+        auto& density = render_->densities[data.curve];
+        auto& histogram = density.histogram;
+        if (histogram.width() != width or histogram.height() != height) {
+            histogram.resize(width, height);
+            density.generation = 0;
+        }
+        if (density.generation != data.generation) {
+            histogram.clear();
+            density.generation = data.generation;
+            density.next_sample = data.first_sample;
+        }
+        histogram.decay(persistence);
+
+        // Only the samples added since the previous frame are accumulated
+        uint64_t first = std::max(density.next_sample, data.first_sample);
+        PointXY point;
+        data.read(
+            [this, &histogram, &point](const PointXY* points, size_t count) {
+                for (size_t i = 0; i < count; ++i) {
+                    scaleToPlot(points[i], point);
+                    histogram.add(PointXY(point.first - plot_offset_.first,
+                                          point.second - plot_offset_.second));
+                }
+            },
+            size_t(first - data.first_sample));
+        density.next_sample = data.first_sample + data.size();
+
+        render_->commands.setColor(palette_[idx++ % palette_.size()]);
+        histogram.render(render_->commands.image(plot_offset_, width, height));
     }
+
+    releaseHiddenCurves(render_->densities, render_->frame_curves);
 }
 
 void RTPlotCore::drawLabels() {
+    RTPLOT_PROFILE_PHASE(profiler_.get(), FramePhase::Labels);
     int texth = 16, yoffset = 0, idx = 0;
+    int row_height = labelRowHeight();
     int xstart = plot_offset_.first + plot_size_.first + 10;
     int ystart;
 
-    pushClip(PointXY{xstart, getYPosition()},
-             Pairf{xstart + label_area_width_, getHeight()});
+    render_->commands.pushClip(
+        PointXY{xstart, widget_.y},
+        Pairf{xstart + label_area_width_, widget_.height});
 
-    saveColor();
+    render_->commands.saveColor();
 
-    for (auto& data : curves_data_) {
-        auto& lbl = data.second.label;
+    for (auto& data : render_->frame_curves) {
+        auto& lbl = data.label;
 
-        setColor(Colors::Black);
+        render_->commands.setColor(Colors::Black);
 
         ystart = plot_offset_.second + yoffset;
-        drawText(lbl, PointXY{xstart + 30, ystart + texth / 2});
+        render_->commands.text(lbl, PointXY{xstart + 30, ystart + texth / 2});
+        if (display_statistics_ and data.statistics.count > 0) {
+            render_->commands.text(
+                statisticsText(data.statistics),
+                PointXY{xstart + 30, ystart + texth * 3 / 2});
+        }
 
-        setColor(palette_[idx++ % palette_.size()]);
-        startLine();
-        drawLine(PointXY{xstart, ystart + texth / 4},
-                 PointXY{xstart + 20, ystart + texth / 4});
-        endLine();
+        render_->commands.setColor(palette_[idx++ % palette_.size()]);
+        render_->commands.startLine();
+        render_->commands.line(PointXY{xstart, ystart + texth / 4},
+                               PointXY{xstart + 20, ystart + texth / 4});
+        render_->commands.endLine();
 
-        yoffset += texth;
+        yoffset += row_height;
     }
-    restoreColor();
+    render_->commands.restoreColor();
 
-    popClip();
+    render_->commands.popClip();
 }
 
 void RTPlotCore::initScaleToPlot() {
-    current_xrange_ = auto_xrange_ ? xrange_auto_ : xrange_;
-    current_yrange_ = auto_yrange_ ? yrange_auto_ : yrange_;
-
+    RTPLOT_PROFILE_PHASE(profiler_.get(), FramePhase::ScaleInit);
     current_xscale_ =
         plot_size_.first / (current_xrange_.second - current_xrange_.first);
     current_yscale_ =
         plot_size_.second / (current_yrange_.first - current_yrange_.second);
+
+    // The cached screen coordinates are only valid for the transform they
+    // have been computed with
+    auto transform = std::make_tuple(current_xrange_, current_yrange_,
+                                     plot_offset_, plot_size_);
+    if (transform != screen_transform_) {
+        screen_transform_ = transform;
+        for (auto& cache : render_->screen_caches) {
+            cache.second.clear();
+        }
+        for (auto& density : render_->densities) {
+            density.second.generation = 0;
+        }
+    }
 }
 
 void RTPlotCore::scaleToPlot(const PointXY& in_point, PointXY& out_point) {
@@ -541,9 +3073,8 @@ void RTPlotCore::scaleToPlot(const PointXY& in_point, PointXY& out_point) {
 
 RTPlotCore::PointXY RTPlotCore::scaleToGraph(const PointXY& point) {
     PointXY ret;
-    Pairf xrange, yrange;
-    xrange = auto_xrange_ ? xrange_auto_ : xrange_;
-    yrange = auto_yrange_ ? yrange_auto_ : yrange_;
+    const auto& xrange = current_xrange_;
+    const auto& yrange = current_yrange_;
     ret.first = xrange.first + (xrange.second - xrange.first) *
                                    (point.first - plot_offset_.first) /
                                    plot_size_.first;
@@ -554,24 +3085,23 @@ RTPlotCore::PointXY RTPlotCore::scaleToGraph(const PointXY& point) {
     return ret;
 }
 
-void RTPlotCore::drawXTickValue(float num, const PointXY& point) {
-
-    char str[15];
-    snprintf(str, 15, "%.2f", num);
-    auto value = std::string(str);
-    auto txt_size = measureText(value);
-    drawText(value, PointXY{point.first - txt_size.first / 2,
-                            point.second + txt_size.second});
+void RTPlotCore::drawXTickValue(const std::string& value,
+                                const PointXY& point) {
+    render_->commands.text(value, point, PointXY{-0.5f, 0.f},
+                           PointXY{0.f, 1.f});
 }
 
-void RTPlotCore::drawYTickValue(float num, const PointXY& point) {
+void RTPlotCore::drawYTickValue(const std::string& value,
+                                const PointXY& point) {
+    render_->commands.text(value, PointXY{point.first - 5, point.second - 2},
+                           PointXY{-1.f, 0.f}, PointXY{0.f, 0.5f});
+}
 
-    char str[15];
-    snprintf(str, 15, "%.2f", num);
-    auto value = std::string(str);
-    auto txt_size = measureText(value);
-    drawText(value, PointXY{point.first - txt_size.first - 5,
-                            point.second + txt_size.second / 2 - 2});
+bool RTPlotCore::insidePlot(const PointXY& position) const {
+    return position.first >= plot_offset_.first and
+           position.first <= plot_offset_.first + plot_size_.first and
+           position.second >= plot_offset_.second and
+           position.second <= plot_offset_.second + plot_size_.second;
 }
 
 void RTPlotCore::handleLeftClick(PointXY cursor_position) {
@@ -587,12 +3117,17 @@ void RTPlotCore::handleLeftClick(PointXY cursor_position) {
             ((cursor_position.second > ystart) and
              (cursor_position.second < yend))) {
 
-            int curve_idx = (cursor_position.second - plot_offset_.second) / 16;
-            if (curve_idx < curves_data_.size()) {
-                auto curve_pos = curves_data_.begin();
-                std::advance(curve_pos, curve_idx);
-                toggleCurveVisibility(curve_pos->first);
+            int curve_idx = (cursor_position.second - plot_offset_.second) /
+                            labelRowHeight();
+            int curve_id;
+            {
+                std::lock_guard<std::mutex> curves_lock(curves_lock_);
+                if (curve_idx < 0 or curve_idx >= int(curves_.size())) {
+                    return;
+                }
+                curve_id = curves_[curve_idx]->id;
             }
+            toggleCurveVisibility(curve_id);
         }
     }
-}
\ No newline at end of file
+}
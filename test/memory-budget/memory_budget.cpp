@@ -0,0 +1,174 @@
+/*      File: memory_budget.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/rtplot_core.h>
+
+#include <iostream>
+
+using namespace rtp;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* message) {
+    if (not condition) {
+        std::cerr << "FAILED: " << message << '\n';
+        ++failures;
+    }
+}
+
+// Plot drawing nowhere
+class TestPlot : public RTPlotCore {
+public:
+    void draw() {
+        drawPlot();
+    }
+
+    size_t samples(int curve) {
+        for (const auto& metrics : getMetrics().curves) {
+            if (metrics.curve == curve) {
+                return metrics.samples;
+            }
+        }
+        return 0;
+    }
+
+    void refresh() override {
+    }
+    void setSize(const Pairf&) override {
+    }
+    void setPosition(const PointXY&) override {
+    }
+
+protected:
+    size_t getWidth() override {
+        return 640;
+    }
+    size_t getHeight() override {
+        return 480;
+    }
+    int getXPosition() override {
+        return 0;
+    }
+    int getYPosition() override {
+        return 0;
+    }
+    void pushClip(const PointXY&, const Pairf&) override {
+    }
+    void popClip() override {
+    }
+    void startLine() override {
+    }
+    void drawLine(const PointXY&, const PointXY&) override {
+    }
+    void endLine() override {
+    }
+    void setLineStyle(LineStyle) override {
+    }
+    void drawText(const std::string&, const PointXY&, int) override {
+    }
+    Pairf measureText(const std::string& text) override {
+        return Pairf(7.f * text.size(), 12.f);
+    }
+    void setColor(Colors) override {
+    }
+    void saveColor() override {
+    }
+    void restoreColor() override {
+    }
+};
+
+constexpr size_t samples_per_curve = 50000;
+
+void fill(TestPlot& plot, int curve) {
+    for (size_t i = 0; i < samples_per_curve; ++i) {
+        plot.addPoint(curve, float(i), float(i % 100));
+    }
+}
+
+} // namespace
+
+int main() {
+    TestPlot frozen, live;
+    fill(frozen, 0);
+    fill(frozen, 1);
+    fill(live, 0);
+    frozen.draw();
+    live.draw();
+
+    auto curve = frozen.getMemoryUsage(0);
+    check(curve.samples >= samples_per_curve * sizeof(RTPlotCore::PointXY),
+          "samples not accounted for");
+    auto total = RTPlotCore::getGlobalMemoryUsage().total();
+    check(total == RTPlotCore::getMemoryUsage({&frozen, &live}).total(),
+          "global usage differs from the plots one");
+    check(total == RTPlotCore::getMemoryUsage({&frozen, &live, &live}).total(),
+          "plot accounted for twice");
+
+    // The frozen plot's samples are older but can't be freed, only the live
+    // plot's ones are evicted
+    frozen.freeze();
+    frozen.draw();
+    RTPlotCore::setMemoryBudget(total / 2);
+    check(frozen.samples(0) == samples_per_curve and
+              frozen.samples(1) == samples_per_curve,
+          "frozen curves evicted");
+    check(live.samples(0) < samples_per_curve, "live curve not evicted");
+
+    // Once resumed, the oldest samples are evicted until the budget is met
+    frozen.resume();
+    frozen.draw();
+    RTPlotCore::setMemoryBudget(total / 2);
+    check(frozen.samples(0) < samples_per_curve,
+          "resumed curves not evicted");
+    check(RTPlotCore::getGlobalMemoryUsage().total() <= total / 2,
+          "memory budget exceeded");
+    check(frozen.samples(0) + frozen.samples(1) + live.samples(0) > 0,
+          "all the curves wiped");
+
+    RTPlotCore::setMemoryBudget(0);
+
+    // The storage of a reserved curve is kept, only the samples exceeding it
+    // are evicted
+    TestPlot reserved;
+    reserved.reserve(0, samples_per_curve);
+    fill(reserved, 0);
+    reserved.draw();
+    RTPlotCore::setMemoryBudget(1);
+    check(reserved.samples(0) == samples_per_curve,
+          "samples evicted from reserved storage");
+    fill(reserved, 0);
+    fill(reserved, 0);
+    reserved.draw();
+    RTPlotCore::setMemoryBudget(1);
+    check(reserved.samples(0) >= samples_per_curve and
+              reserved.samples(0) < 3 * samples_per_curve,
+          "samples exceeding the reserved storage not evicted");
+    check(reserved.getMemoryUsage(0).samples >=
+              samples_per_curve * sizeof(RTPlotCore::PointXY),
+          "reserved storage freed");
+
+    RTPlotCore::setMemoryBudget(0);
+
+    if (failures == 0) {
+        std::cout << "All memory budget checks passed\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,308 @@
+/*      File: no_allocation.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/rtplot_core.h>
+#include <rtplot/curve_handle.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace rtp;
+
+namespace {
+
+// Count the allocations made while armed. The library only allocates through
+// operator new
+std::atomic<bool> armed{false};
+std::atomic<size_t> allocations{0};
+
+void* allocate(size_t size) {
+    if (armed.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+int failures = 0;
+// Features enabled during the current checks
+const char* scenario = "";
+
+void check(bool condition, const char* message) {
+    if (not condition) {
+        std::cerr << "FAILED (" << scenario << "): " << message << '\n';
+        ++failures;
+    }
+}
+
+// Plot drawing nowhere
+class TestPlot : public RTPlotCore {
+public:
+    void draw() {
+        drawPlot();
+    }
+
+    void refresh() override {
+    }
+    void setSize(const Pairf&) override {
+    }
+    void setPosition(const PointXY&) override {
+    }
+
+protected:
+    size_t getWidth() override {
+        return 640;
+    }
+    size_t getHeight() override {
+        return 480;
+    }
+    int getXPosition() override {
+        return 0;
+    }
+    int getYPosition() override {
+        return 0;
+    }
+    void pushClip(const PointXY&, const Pairf&) override {
+    }
+    void popClip() override {
+    }
+    void startLine() override {
+    }
+    void drawLine(const PointXY&, const PointXY&) override {
+    }
+    void endLine() override {
+    }
+    void setLineStyle(LineStyle) override {
+    }
+    void drawText(const std::string&, const PointXY&, int) override {
+    }
+    Pairf measureText(const std::string& text) override {
+        return Pairf(7.f * text.size(), 12.f);
+    }
+    void setColor(Colors) override {
+    }
+    void saveColor() override {
+    }
+    void restoreColor() override {
+    }
+};
+
+// Large enough to span several storage segments and age marks
+constexpr size_t max_points = 10000;
+constexpr size_t channels = 4;
+constexpr size_t batch = 64;
+
+// The producers of the two plots
+struct Producers {
+    CurveHandle points;
+    CurveHandle samples;
+    CurveHandle triggered;
+    size_t added = 0;
+
+    void add(TestPlot& frames, size_t count) {
+        float ys[batch];
+        float frame[channels];
+        for (size_t i = 0; i < count; ++i, ++added) {
+            float x = float(added);
+            float y = float(added % 100);
+            points.addPoint(x, y);
+            triggered.addPoint(x, y);
+            for (auto& value : ys) {
+                value = y;
+            }
+            if (added % batch == 0) {
+                samples.addSamples(ys, batch);
+            } else {
+                samples.addSample(y);
+            }
+            for (size_t channel = 0; channel < channels; ++channel) {
+                frame[channel] = y + float(channel);
+            }
+            frames.addFrame(x, frame, channels);
+        }
+    }
+};
+
+// Add samples while checking that nothing allocates
+template <typename Add> void checkAdd(Add add, const char* message) {
+    allocations.store(0);
+    armed.store(true);
+    add();
+    armed.store(false);
+    if (allocations.load() > 0) {
+        std::cerr << allocations.load() << " allocations\n";
+    }
+    check(allocations.load() == 0, message);
+}
+
+// Feed curves of every kind, drawn, frozen or not, with the automatic
+// ranges and the statistics maintained by the producers if tracking is set
+void checkProducers(bool tracking) {
+    TestPlot plot, frames;
+    if (tracking) {
+        for (auto target : {&plot, &frames}) {
+            target->setAutoXRange();
+            target->setAutoYRange();
+            target->enableStatistics(true);
+        }
+    }
+
+    // setMaxPoints() only applies to the existing curves
+    plot.setUniformSampling(1, 0.f, 1.f);
+    plot.reserve(0, max_points);
+    plot.reserve(1, max_points);
+    plot.setTrigger(2, TriggerMode::RisingEdge, 50.f, 20, 20, 3);
+    plot.reserve(2, max_points);
+    plot.setMaxPoints(max_points);
+
+    // Create the series, then reserve its channels
+    float frame[channels] = {};
+    frames.addFrame(0.f, frame, channels);
+    frames.setMaxPoints(max_points);
+    for (size_t channel = 0; channel < channels; ++channel) {
+        frames.reserve(int(channel), max_points);
+    }
+
+    Producers producers;
+    producers.points = plot.getCurveHandle(0);
+    producers.samples = plot.getCurveHandle(1);
+    producers.triggered = plot.getCurveHandle(2);
+
+    // Fill the curves, then keep adding past max_points so that the oldest
+    // samples and age marks get evicted
+    checkAdd([&] { producers.add(frames, max_points); },
+             "allocation while filling");
+    checkAdd([&] { producers.add(frames, 3 * max_points); },
+             "allocation while evicting samples");
+
+    // Drawing captures the curves, the captured samples being released once
+    // the frame is recorded
+    plot.draw();
+    frames.draw();
+    checkAdd([&] { producers.add(frames, 2 * max_points); },
+             "allocation with a frame captured");
+
+    // A frozen plot holds its snapshots until it is resumed
+    plot.freeze();
+    frames.freeze();
+    plot.draw();
+    frames.draw();
+    checkAdd([&] { producers.add(frames, 3 * max_points); },
+             "allocation with the plots frozen");
+    plot.resume();
+    frames.resume();
+    plot.draw();
+    frames.draw();
+    checkAdd([&] { producers.add(frames, 2 * max_points); },
+             "allocation after resuming the plots");
+}
+
+// A curve grown past its reserved storage is evicted down to it by the memory
+// budget, the reserved part being kept
+void checkBudgetEviction() {
+    TestPlot plot;
+    plot.reserve(0, max_points);
+    auto handle = plot.getCurveHandle(0);
+    size_t added = 0;
+    auto add = [&handle, &added](size_t count) {
+        for (size_t i = 0; i < count; ++i, ++added) {
+            handle.addPoint(float(added), float(added % 100));
+        }
+    };
+    add(3 * max_points);
+    plot.draw();
+    RTPlotCore::setMemoryBudget(1);
+    plot.setMaxPoints(max_points);
+    checkAdd([&] { add(3 * max_points); },
+             "allocation after a memory budget eviction");
+    plot.draw();
+    checkAdd([&] { add(3 * max_points); },
+             "allocation after drawing an evicted curve");
+    RTPlotCore::setMemoryBudget(0);
+}
+
+} // namespace
+
+int main() {
+    scenario = "points, samples, frames and triggers";
+    checkProducers(false);
+
+    scenario = "automatic ranges and statistics";
+    checkProducers(true);
+
+    scenario = "memory budget";
+    checkBudgetEviction();
+    // The curves not exceeding their reserved storage are left untouched
+    RTPlotCore::setMemoryBudget(1);
+    checkProducers(true);
+    RTPlotCore::setMemoryBudget(0);
+
+    if (failures == 0) {
+        std::cout << "All no allocation checks passed\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+/*      File: trigger_capture.cpp
+ *       This file is part of the program rtplot-core
+ *       Program description : Core functionalities to be used by GUI libraries
+ * for real time plotting Copyright (C) 2018 -  Benjamin Navarro (LIRMM). All
+ * Right reserved.
+ *
+ *       This software is free software: you can redistribute it and/or modify
+ *       it under the terms of the CeCILL license as published by
+ *       the CEA CNRS INRIA, either version 2.1
+ *       of the License, or (at your option) any later version.
+ *       This software is distributed in the hope that it will be useful,
+ *       but WITHOUT ANY WARRANTY without even the implied warranty of
+ *       MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *       CeCILL License for more details.
+ *
+ *       You should have received a copy of the CeCILL License
+ *       along with this software. If not, it can be found on the official
+ * website of the CeCILL licenses family (http://www.cecill.info/index.en.html).
+ */
+#include <rtplot/internal/trigger_capture.h>
+
+#include <iostream>
+
+using namespace rtp;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* message) {
+    if (not condition) {
+        std::cerr << "FAILED: " << message << '\n';
+        ++failures;
+    }
+}
+
+// Feed y = x for x in [first, last[
+void feed(TriggerCapture& capture, int first, int last) {
+    for (int x = first; x < last; ++x) {
+        capture.process(float(x), float(x));
+    }
+}
+
+} // namespace
+
+int main() {
+    constexpr size_t pre_samples = 8;
+    constexpr size_t post_samples = 5;
+
+    // Full history: the sweep holds the pre-trigger window, the triggering
+    // sample and the post-trigger ones
+    {
+        TriggerCapture capture(TriggerMode::Threshold, 20.f, pre_samples,
+                               post_samples, 4);
+        feed(capture, 0, 20);
+        check(capture.captures() == 0, "no capture before the trigger");
+        feed(capture, 20, 20 + int(post_samples));
+        check(capture.captures() == 0, "capture completed too early");
+        feed(capture, 20 + int(post_samples), 21 + int(post_samples));
+        check(capture.captures() == 1, "capture not completed");
+        if (capture.sweeps().empty()) {
+            return 1;
+        }
+        const auto& sweep = *capture.sweeps().back();
+        check(sweep.trigger_index == pre_samples, "wrong pre-trigger count");
+        check(sweep.points.size() == pre_samples + 1 + post_samples,
+              "wrong sweep size");
+        check(sweep.trigger_x == 20.f, "wrong trigger position");
+        check(sweep.points.front().first == 20.f - pre_samples,
+              "wrong first sample");
+        check(sweep.points.back().first == 20.f + post_samples,
+              "wrong last sample");
+    }
+
+    // Short history: the trigger fires after only 3 samples, the sweep still
+    // ends exactly post_samples after the trigger
+    {
+        TriggerCapture capture(TriggerMode::Threshold, 3.f, pre_samples,
+                               post_samples, 4);
+        feed(capture, 0, 4 + int(post_samples));
+        check(capture.captures() == 1, "short history capture not completed");
+        if (capture.sweeps().empty()) {
+            return 1;
+        }
+        const auto& sweep = *capture.sweeps().back();
+        check(sweep.trigger_index == 3, "wrong short pre-trigger count");
+        check(sweep.points.size() == 3 + 1 + post_samples,
+              "wrong short sweep size");
+        check(sweep.points.back().first == 3.f + post_samples,
+              "short sweep has extra post-trigger samples");
+        check(sweep.xmax == float(post_samples), "wrong short sweep bounds");
+    }
+
+    // No post-trigger samples: the sweep completes on the trigger
+    {
+        TriggerCapture capture(TriggerMode::RisingEdge, 2.5f, pre_samples, 0,
+                               4);
+        feed(capture, 0, 4);
+        check(capture.captures() == 1, "capture not completed on trigger");
+        check(capture.sweeps().size() == 1 and
+                  capture.sweeps().back()->points.size() == 4,
+              "wrong sweep size without post-trigger samples");
+    }
+
+    // Reused sweeps are refilled with the same bounds
+    {
+        TriggerCapture capture(TriggerMode::RisingEdge, 0.5f, pre_samples,
+                               post_samples, 1);
+        for (int i = 0; i < 10; ++i) {
+            capture.process(0.f, 0.f);
+            feed(capture, 1, 2 + int(post_samples));
+            for (int j = 0; j < 10; ++j) {
+                capture.process(0.f, 0.f);
+            }
+        }
+        check(capture.captures() == 10, "wrong number of captures");
+        if (capture.sweeps().empty()) {
+            return 1;
+        }
+        const auto& sweep = *capture.sweeps().back();
+        check(sweep.points.size() == pre_samples + 1 + post_samples,
+              "wrong reused sweep size");
+    }
+
+    if (failures == 0) {
+        std::cout << "All trigger capture checks passed\n";
+    }
+    return failures == 0 ? 0 : 1;
+}